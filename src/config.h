@@ -12,6 +12,33 @@
 // CFG_ALARM 1 or 0
 // CFG_CHIME 1 or 0
 // CFG_GPS_CORRECTION in 10 ms ticks
+// CFG_GPS_BAUD baud rate of the GPS receiver, 9600 or 19200 at 11.0592 MHz (38400 and 115200
+//             are rejected by main.c, set such a receiver to one of them first)
+// CFG_GPS_UBX 0 (NMEA RMC) or 1 (u-blox UBX-NAV-TIMEUTC, must be enabled in the receiver)
+// CFG_GPS_AUTO_CORRECTION 0 or 1 (learn how long after the start of its output the receiver
+//             delivers the fix, CFG_GPS_CORRECTION is only the start value; the fix + 1 s is
+//             written when the next second starts)
+// CFG_GPS_OUTPUT_DELAY in 10 ms ticks, from the second to the first byte the receiver sends
+// CFG_GPS_PPS 0 or 1 (1PPS of the receiver on P3.6, falling edge at the second, i.e. inverted;
+//             the time is written at the pulse, CFG_GPS_CORRECTION is not used)
+//             INT2 takes only falling edges: a receiver with a rising edge at the second (most do)
+//             needs an external inverter, e.g. a transistor, else the write is late by the pulse length.
+//             int2_isr only sets a flag, _delay_ms() polls it: a pulse during the rest of the main
+//             loop (DS1302 read, display, ADC) waits for its next _delay_ms(), then for gpsCopyToRtc()
+//             until ds_writeburst(); expected to be a few ms, not measured on the target
+// CFG_GPS_SYNC_INTERVAL in minutes, 0 = write every fix to the DS1302; else a fix is only written
+//             if the DS1302 is off by more than CFG_GPS_SYNC_THRESHOLD or the interval has passed
+// CFG_GPS_SYNC_THRESHOLD in seconds (1 allows for reading the DS1302 just before its second ticks)
+// CFG_GPS_CONSENSUS 0 or 1 (a fix is only used if the RMC status is A and it is the third one
+//             in consecutive seconds)
+// CFG_GPS_STATUS 0 or 1 (fix quality and satellites in use from GGA, shown after the seconds)
+// CFG_GPS_HOLDOVER 0 or 1 (learn the drift of the DS1302 from the GPS writes and trim it by
+//             seconds while there is no GPS; needs CFG_GPS_SYNC_INTERVAL, best some hours)
+// CFG_GPS_INIT 0, 'M' or 'U' (when the receiver first talks, switch off all its output but RMC,
+//             and GGA with CFG_GPS_STATUS, through a soft-uart tx on P1.3: 'M' MediaTek PMTK314,
+//             'U' u-blox PUBX,40; with CFG_GPS_UBX 'U' sends UBX-CFG-MSG for NAV-TIMEUTC only)
+// CFG_SOFT_CLOCK 0 or 1 (the time runs on the 10 ms timer, the DS1302 is only read at its
+//             tick around each minute and after the time is changed, not every 100 ms)
 // other durations are in 100 ms ticks
 // defaults for the configuration options:
 
@@ -63,5 +90,53 @@
 #define CFG_GPS_CORRECTION 88
 #endif
 
+#ifndef CFG_GPS_BAUD
+#define CFG_GPS_BAUD 9600
+#endif
+
+#ifndef CFG_GPS_UBX
+#define CFG_GPS_UBX 0
+#endif
+
+#ifndef CFG_GPS_AUTO_CORRECTION
+#define CFG_GPS_AUTO_CORRECTION 0
+#endif
+
+#ifndef CFG_GPS_OUTPUT_DELAY
+#define CFG_GPS_OUTPUT_DELAY 5
+#endif
+
+#ifndef CFG_GPS_PPS
+#define CFG_GPS_PPS 0
+#endif
+
+#ifndef CFG_GPS_SYNC_INTERVAL
+#define CFG_GPS_SYNC_INTERVAL 0
+#endif
+
+#ifndef CFG_GPS_SYNC_THRESHOLD
+#define CFG_GPS_SYNC_THRESHOLD 1
+#endif
+
+#ifndef CFG_GPS_CONSENSUS
+#define CFG_GPS_CONSENSUS 0
+#endif
+
+#ifndef CFG_GPS_STATUS
+#define CFG_GPS_STATUS 0
+#endif
+
+#ifndef CFG_GPS_HOLDOVER
+#define CFG_GPS_HOLDOVER 0
+#endif
+
+#ifndef CFG_GPS_INIT
+#define CFG_GPS_INIT 0
+#endif
+
+#ifndef CFG_SOFT_CLOCK
+#define CFG_SOFT_CLOCK 0
+#endif
+
 #endif // CONFIG_H
 
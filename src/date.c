@@ -0,0 +1,57 @@
+#include "date.h"
+
+uint8_t date_daysInMonth(uint8_t y, uint8_t m) {
+    switch(m) {
+        case 4:
+        case 6:
+        case 9:
+        case 11:
+            return 30;
+
+        case 2:
+            return (y % 4 == 0 ? 29 : 28);
+
+        default:
+            return 31;
+    }
+}
+
+uint8_t date_dayOfWeek(uint8_t y, uint8_t m, uint8_t d) {
+    static const uint8_t OFFSETS[] = { 1, 4, 4, 0, 2, 5, 0, 3, 6, 1, 4, 6 };
+    uint8_t v = y / 4 + d + OFFSETS[m-1];
+    if((y % 4 == 0) && (m == 1 || m == 2)) v -= 1;
+    v += 6 /* correct for 2000-2099 */ + y + 5;
+    v %= 7;
+    return (v + 1);
+}
+
+void date_addHours(struct date_Date * dt, int8_t hours) {
+    if(hours < 0) {
+        uint8_t v = -hours;
+        if(dt->hour < v) {
+            dt->hour += 24;
+            if(--dt->day == 0) {
+                // month and year first, the length of the previous month depends on them
+                if(--dt->month == 0) {
+                    dt->month = 12;
+                    dt->year = dt->year ? dt->year - 1 : 99;
+                }
+                dt->day = date_daysInMonth(dt->year, dt->month);
+            }
+        }
+        dt->hour -= v;
+    }
+    else {
+        dt->hour += hours;
+        if(dt->hour > 23) {
+            dt->hour -= 24;
+            if(++dt->day > date_daysInMonth(dt->year, dt->month)) {
+                dt->day = 1;
+                if(++dt->month > 12) {
+                    dt->month = 1;
+                    dt->year = dt->year < 99 ? dt->year + 1 : 0;
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,23 @@
+#ifndef DATE_H
+#define DATE_H
+
+#include <stdint.h>
+
+// calendar arithmetic for 2000-2099, works on its arguments only
+
+struct date_Date {
+    uint8_t year;   // 0-99
+    uint8_t month;  // 1-12
+    uint8_t day;    // 1-31
+    uint8_t hour;   // 0-23
+};
+
+uint8_t date_daysInMonth(uint8_t y, uint8_t m);
+
+// 1 = Monday .. 7 = Sunday
+uint8_t date_dayOfWeek(uint8_t y, uint8_t m, uint8_t d);
+
+// shift by -23..+23 hours, rolling over day, month and year (99 <-> 0)
+void date_addHours(struct date_Date * dt, int8_t hours);
+
+#endif // DATE_H
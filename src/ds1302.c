@@ -4,32 +4,6 @@
 
 #include "ds1302.h"
 
-#define MAGIC_HI  0x5A
-#define MAGIC_LO  0xA5
-
-void ds_ram_config_init(uint8_t * config) {
-    uint8_t i;
-    // check magic bytes to see if ram has been written before
-    if ( (ds_readbyte( DS_CMD_RAM >> 1 | 0x00) != MAGIC_LO || ds_readbyte( DS_CMD_RAM >> 1 | 0x01) != MAGIC_HI) ) {
-        // if not, must init ram config to defaults
-        ds_writebyte( DS_CMD_RAM >> 1 | 0x00, MAGIC_LO);
-        ds_writebyte( DS_CMD_RAM >> 1 | 0x01, MAGIC_HI);
-
-        for (i=0; i<sizeof(struct ram_config); i++)
-            ds_writebyte( DS_CMD_RAM >> 1 | (i+2), 0x00);
-    }
-
-    // read ram config
-    for (i=0; i<sizeof(struct ram_config); i++)
-        config[i] = ds_readbyte(DS_CMD_RAM >> 1 | (i+2));
-}
-
-void ds_ram_config_write(uint8_t const * config) {
-    uint8_t i;
-    for (i=0; i<sizeof(struct ram_config); i++)
-        ds_writebyte( DS_CMD_RAM >> 1 | (i+2), config[i]);
-}
-
 static void ds_sendByte(uint8_t b) {
     uint8_t i;
 
@@ -101,6 +75,88 @@ void ds_writeburst(uint8_t const time[8]) {
     ds_sendEnd();
 }
 
+// ram 0: version and size of the config, ram 1: crc-8 of both and the config, ram 2..: config
+// fields are only added at the end of ram_config, count the version up if one changes
+#define CONFIG_VERSION  1
+#define CONFIG_HEADER   (CONFIG_VERSION << 5 | sizeof(struct ram_config))
+
+// the fields up to time_offset, the same since the magic bytes
+#define CONFIG_BASE     8
+
+// before the header: magic bytes, then the base fields
+#define MAGIC_HI    0x5A
+#define MAGIC_LO    0xA5
+
+// ram burst always starts at ram 0
+#define DS_CMD_RAM_BURST  (DS_CMD | DS_CMD_RAM | DS_BURST_MODE << 1)
+
+static uint8_t ds_crc8(uint8_t crc, uint8_t b) {
+    uint8_t i;
+    crc ^= b;
+    for (i=0; i < 8; i++)
+        crc = (crc & 0x80) ? crc << 1 ^ 0x07 : crc << 1;
+    return crc;
+}
+
+static uint8_t ds_ram_config_crc(uint8_t const * config) {
+    uint8_t i, crc = ds_crc8(0, CONFIG_HEADER);
+    for (i=0; i<sizeof(struct ram_config); i++)
+        crc = ds_crc8(crc, config[i]);
+    return crc;
+}
+
+void ds_ram_config_init(uint8_t * config) {
+    uint8_t i, b, header, crc, size, c;
+    ds_sendBegin(DS_CMD_RAM_BURST | DS_CMD_READ);
+    header = ds_recvByte();
+    crc = ds_recvByte();
+    if (header == MAGIC_LO && crc == MAGIC_HI)
+        size = CONFIG_BASE;
+    else if (header == CONFIG_HEADER)
+        size = sizeof(struct ram_config);
+    else
+        size = 0;
+    c = ds_crc8(0, header);
+    for (i=0; i<size; i++) {
+        b = ds_recvByte();
+        c = ds_crc8(c, b);
+        config[i] = b;
+    }
+    ds_sendEnd();
+
+    if (size == CONFIG_BASE && header == MAGIC_LO)
+        c = crc; // no crc before the header
+    if (c != crc)
+        size = 0;
+
+    // fields added since, or all if the ram is not valid, are 0
+    for (i=size; i<sizeof(struct ram_config); i++)
+        config[i] = 0x00;
+
+    if (size != sizeof(struct ram_config)) {
+        // new header, so everything in one burst
+        ds_sendBegin(DS_CMD_RAM_BURST | DS_CMD_WRITE);
+        ds_sendByte(CONFIG_HEADER);
+        ds_sendByte(ds_ram_config_crc(config));
+        for (i=0; i<sizeof(struct ram_config); i++)
+            ds_sendByte(config[i]);
+        ds_sendEnd();
+    }
+}
+
+void ds_ram_config_write(uint8_t const * config) {
+    uint8_t i, changed = 0;
+    for (i=0; i<sizeof(struct ram_config); i++) {
+        // compared with the ram itself, there is no room for a copy in the mcu
+        if (config[i] != ds_readbyte(DS_CMD_RAM >> 1 | (i+2))) {
+            ds_writebyte(DS_CMD_RAM >> 1 | (i+2), config[i]);
+            changed = 1;
+        }
+    }
+    if (changed)
+        ds_writebyte(DS_CMD_RAM >> 1 | 1, ds_ram_config_crc(config));
+}
+
 void ds_init() {
     uint8_t b = ds_readbyte(DS_ADDR_SECONDS);
     ds_writebyte(DS_ADDR_WP, 0); // clear WP
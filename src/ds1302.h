@@ -72,7 +72,7 @@ typedef struct ds1302_rtc {
     uint8_t write_protect:1;
 };
 
-// ram config stored in rtc
+// ram config stored in rtc, new fields go to the end (see CONFIG_VERSION)
 typedef struct ram_config {
     int8_t    temp_offset;
 
@@ -85,10 +85,16 @@ typedef struct ram_config {
     uint8_t   chime_hour_stop;
 
     int8_t    time_offset;
+
+    // in every build, so the layout does not depend on the options
+    uint8_t   gps_latency;  // learned gps_latency, 0 = nothing learned yet (CFG_GPS_AUTO_CORRECTION)
+    int16_t   gps_drift;    // of the DS1302 in 0.1 ppm, positive = runs fast (CFG_GPS_HOLDOVER)
 };
 
+// read ram config, all 0 if it does not pass the crc
 void ds_ram_config_init(uint8_t * config);
 
+// write the bytes changed since, and the crc
 void ds_ram_config_write(uint8_t const * config);
 
 // ds1302 single-byte read
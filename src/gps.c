@@ -1,9 +1,151 @@
 #include "gps.h"
 
+#include <stddef.h>
 #include <stc12.h>
 #include "ds1302.h"
 #include "uart.h"
 
+#if CFG_GPS_PPS == 1
+// 10 ms ticks a fix waits for the next pulse, an older one belongs to an earlier second
+#define GPS_WAIT 95
+#else
+#define GPS_WAIT CFG_GPS_CORRECTION
+#endif
+
+#if CFG_GPS_AUTO_CORRECTION == 1
+#if CFG_GPS_PPS == 1
+#error "CFG_GPS_AUTO_CORRECTION is not used with CFG_GPS_PPS"
+#endif
+#define GPS_PAUSE 10  // 10 ms ticks without a byte between the outputs of two seconds
+#define GPS_SECOND (100 - CFG_GPS_OUTPUT_DELAY)
+
+uint8_t gps_latency = GPS_SECOND - CFG_GPS_CORRECTION;
+static uint8_t idle;
+static uint8_t burst;  // 10 ms ticks since the first byte after a pause
+#endif
+
+#if CFG_GPS_STATUS == 1 && CFG_GPS_UBX == 1
+#error "CFG_GPS_STATUS needs the NMEA parser"
+#endif
+
+#if CFG_GPS_CONSENSUS == 1
+#define GPS_AGREE 2  // fixes that have to precede one, each a second before the next
+#define GPS_HOUR_DATE offsetof(struct gps_DateTime, hour)  // hour to tenyear
+static uint16_t lastSecond; // of the hour, of the last fix
+static uint8_t lastHourDate[8];
+static uint8_t agree;
+#endif
+
+struct gps_DateTime gps_datetime;
+static uint8_t pos;
+static uint8_t sum1;
+static uint8_t sum2;
+
+static void gps_fix();
+
+#if CFG_GPS_INIT != 0
+#if CFG_GPS_INIT == 'U' && CFG_GPS_UBX == 1
+// UBX-CFG-MSG: NAV-TIMEUTC every solution, NMEA GGA, GLL, GSA, GSV, RMC, VTG off
+static __code const uint8_t GPS_INIT[] = {
+    0xB5, 0x62, 0x06, 0x01, 0x03, 0x00, 0x01, 0x21, 0x01, 0x2D, 0x85,
+    0xB5, 0x62, 0x06, 0x01, 0x03, 0x00, 0xF0, 0x00, 0x00, 0xFA, 0x0F,
+    0xB5, 0x62, 0x06, 0x01, 0x03, 0x00, 0xF0, 0x01, 0x00, 0xFB, 0x11,
+    0xB5, 0x62, 0x06, 0x01, 0x03, 0x00, 0xF0, 0x02, 0x00, 0xFC, 0x13,
+    0xB5, 0x62, 0x06, 0x01, 0x03, 0x00, 0xF0, 0x03, 0x00, 0xFD, 0x15,
+    0xB5, 0x62, 0x06, 0x01, 0x03, 0x00, 0xF0, 0x04, 0x00, 0xFE, 0x17,
+    0xB5, 0x62, 0x06, 0x01, 0x03, 0x00, 0xF0, 0x05, 0x00, 0xFF, 0x19,
+};
+#define GPS_INIT_LEN sizeof(GPS_INIT)
+#elif CFG_GPS_INIT == 'U'
+// rates of GLL, GSA, GSV, VTG and without CFG_GPS_STATUS GGA to 0 on all ports
+static __code const char GPS_INIT[] =
+#if CFG_GPS_STATUS == 0
+    "$PUBX,40,GGA,0,0,0,0,0,0*5A\r\n"
+#endif
+    "$PUBX,40,GLL,0,0,0,0,0,0*5C\r\n"
+    "$PUBX,40,GSA,0,0,0,0,0,0*4E\r\n"
+    "$PUBX,40,GSV,0,0,0,0,0,0*59\r\n"
+    "$PUBX,40,VTG,0,0,0,0,0,0*5E\r\n";
+#define GPS_INIT_LEN (sizeof(GPS_INIT) - 1)
+#elif CFG_GPS_INIT == 'M' && CFG_GPS_UBX == 0
+// output rates of GLL, RMC, VTG, GGA, GSA, GSV, ..., ZDA, MCHN; RMC every fix
+static __code const char GPS_INIT[] =
+#if CFG_GPS_STATUS == 0
+    "$PMTK314,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0*29\r\n";
+#else
+    "$PMTK314,0,1,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0*28\r\n";
+#endif
+#define GPS_INIT_LEN (sizeof(GPS_INIT) - 1)
+#else
+#error "CFG_GPS_INIT has to be 'M' (not with CFG_GPS_UBX) or 'U'"
+#endif
+
+static uint8_t initPending;
+#endif
+
+#if CFG_GPS_UBX == 1
+
+// u-blox UBX-NAV-TIMEUTC: sync chars, class, id, 16-bit length, payload, Fletcher checksum
+#define UBX_LEN   20
+#define UBX_DATE  (6 + 12)  // pos of year in the frame, followed by month, day, hour, min, sec, valid
+#define UBX_END   (6 + UBX_LEN)
+#define UBX_VALID_UTC 0x04
+
+static const uint8_t UBX_HEAD[] = { 0xB5, 0x62, 0x01, 0x21, UBX_LEN, 0 };
+static uint8_t ubx[8];
+
+static void ubx_time() {
+    uint16_t year = ubx[0] | ubx[1] << 8;
+
+    if(!(ubx[7] & UBX_VALID_UTC) || year < 2000 || year > 2099) return;
+    year -= 2000;
+
+    gps_datetime.tenyear    = ds_int2bcd_tens(year);
+    gps_datetime.year       = ds_int2bcd_ones(year);
+    gps_datetime.tenmonth   = ds_int2bcd_tens(ubx[2]);
+    gps_datetime.month      = ds_int2bcd_ones(ubx[2]);
+    gps_datetime.tenday     = ds_int2bcd_tens(ubx[3]);
+    gps_datetime.day        = ds_int2bcd_ones(ubx[3]);
+    gps_datetime.tenhour    = ds_int2bcd_tens(ubx[4]);
+    gps_datetime.hour       = ds_int2bcd_ones(ubx[4]);
+    gps_datetime.tenminutes = ds_int2bcd_tens(ubx[5]);
+    gps_datetime.minutes    = ds_int2bcd_ones(ubx[5]);
+    gps_datetime.tenseconds = ds_int2bcd_tens(ubx[6]);
+    gps_datetime.seconds    = ds_int2bcd_ones(ubx[6]);
+
+    gps_fix();
+}
+
+static void gps_byte(uint8_t b) {
+    if(pos < UBX_END) {
+        if(pos < sizeof(UBX_HEAD) && b != UBX_HEAD[pos]) {
+            pos = (b == UBX_HEAD[0]); // other message or garbage, maybe the next sync char
+            return;
+        }
+        if(pos == 2) {
+            sum1 = 0;
+            sum2 = 0;
+        }
+        if(pos >= 2) { // checksum from class to the end of the payload
+            sum1 += b;
+            sum2 += sum1;
+        }
+        if(pos >= UBX_DATE) {
+            ubx[pos - UBX_DATE] = b;
+        }
+        ++pos;
+    }
+    else if(pos == UBX_END) {
+        pos = (b == sum1) ? pos + 1 : (b == UBX_HEAD[0]);
+    }
+    else {
+        if(b == sum2) ubx_time();
+        pos = 0;
+    }
+}
+
+#else // CFG_GPS_UBX == 1
+
 #define STATE_ERROR    0
 #define STATE_NAME     1
 #define STATE_TIME     2
@@ -12,47 +154,101 @@
 #define STATE_TAIL     5
 #define STATE_CHECKSUM 6
 
-struct gps_DateTime gps_datetime;
+#define SENTENCE_RMC   0
+#define SENTENCE_ZDA   1
+#define SENTENCE_GGA   2
+
+// RMC from any talker is used; ZDA is preferred when the receiver sends it,
+// RMC is skipped until ZDA_PREFERRED of them came without a ZDA
+#define ZDA_PREFERRED  3
+
 static uint8_t state = STATE_ERROR;
-static uint8_t pos;
-static uint8_t sum1;
-static uint8_t sum2;
+static uint8_t sentence;
+static uint8_t zdaSeen;
+#if CFG_GPS_CONSENSUS == 1
+static uint8_t status;  // of RMC, A = data valid, V = warning
+#endif
 
-static const char* ALLOWED_CHARS = "$*.,0123456789ABCDEFGMNPRSVW";
+// commas after the name in front of the fields of GGA, its time is skipped
+#define GGA_QUALITY    5
+#define GGA_SATS       6
 
-//$GPRMC,182600.00,V,,,,,,,210916,,,N*7D
+#if CFG_GPS_STATUS == 1
+#define GGA_EXPIRE     250  // 10 ms ticks
 
-void gps_init() {
+uint8_t gps_quality = GPS_STATUS_NONE;
+uint8_t gps_sats = GPS_STATUS_NONE;
+static uint8_t ggaQuality;
+static uint8_t ggaSats;
+static uint8_t ggaExpire;
+#endif
 
-}
+// 4th to 6th character of the name, the 3rd selects the sentence
+static const char NAME_TAIL[][3] = {
+    { 'M', 'C', ',' },
+    { 'D', 'A', ',' },
+#if CFG_GPS_STATUS == 1
+    { 'G', 'A', ',' },
+#endif
+};
 
-void gps_cycle() {
-    uint8_t b;
+// commas from the end of the time to the date, for GGA from the name to the end of the satellites
+static const uint8_t DATE_COMMAS[] = { 8, 1, GGA_SATS + 1 };
 
-    if(REND != 1) return;
+// where each character of the date goes: RMC ddmmyy, ZDA dd,mm,yyyy
+#define DATE_COMMA  0xFE
+#define DATE_SKIP   0xFD
+#define DATE_END    0xFF
+#define DATE_RMC    0
+#define DATE_ZDA    7
+static const uint8_t DATE_FIELDS[] = {
+    offsetof(struct gps_DateTime, tenday),
+    offsetof(struct gps_DateTime, day),
+    offsetof(struct gps_DateTime, tenmonth),
+    offsetof(struct gps_DateTime, month),
+    offsetof(struct gps_DateTime, tenyear),
+    offsetof(struct gps_DateTime, year),
+    DATE_END,
+    offsetof(struct gps_DateTime, tenday),
+    offsetof(struct gps_DateTime, day),
+    DATE_COMMA,
+    offsetof(struct gps_DateTime, tenmonth),
+    offsetof(struct gps_DateTime, month),
+    DATE_COMMA,
+    DATE_SKIP,  // century
+    DATE_SKIP,
+    offsetof(struct gps_DateTime, tenyear),
+    offsetof(struct gps_DateTime, year),
+    DATE_END,
+};
 
-    REND = 0;
-    b = RBUF;
+// letters in the names and fields of the sentences parsed, a bit each for 'A'..'Z':
+// A-F for the checksum, G L M N P R S V W Z; digits and $*,-. are compared, anything else is illegal
+static const uint8_t LETTERS[] = { 0x7F, 0xB8, 0x66, 0x02 };
 
-    {
-        const char* s;
-        __bit ok = 0;
-        for(s = ALLOWED_CHARS; *s; ++s) {
-            if(b == (uint8_t)(*s)) {
-                ok = 1;
-                break;
-            }
-        }
-        if(!ok) {
-            state = STATE_ERROR;
-            return;
-        }
+//$GPRMC,182600.00,V,,,,,,,210916,,,N*7D
+//$GPZDA,182600.00,21,09,2016,00,00*64
+
+static void gps_byte(uint8_t b) {
+    uint8_t v = b - '0';  // value of a digit, > 9 for anything else
+    uint8_t l = b - 'A';
+
+    if(!(v <= 9 || (l < 26 && (LETTERS[l >> 3] & 1 << (l & 7)))
+         || b == '$' || b == '*' || b == ',' || b == '-' || b == '.')) {
+        state = STATE_ERROR;
+        return;
     }
 
     if(b == '$') {
         state = STATE_NAME;
         pos = 0;
         sum1 = 0;
+        #if CFG_GPS_CONSENSUS == 1
+        status = 0;
+        #endif
+    }
+    else if(b == '*' && state != STATE_TAIL) {
+        state = STATE_ERROR; // '*' is only allowed in front of the checksum
     }
     else {
         switch(state) {
@@ -60,22 +256,43 @@ void gps_cycle() {
                 break;
 
             case STATE_NAME:
-            case STATE_TIME:
-            case STATE_DATE: // fill the buffer
+            case STATE_TIME: // fill the buffer
                 if(pos < 6) {
-                    uint8_t v = (b - '0');
                     sum1 ^= b;
                     switch(state) {
-                        case STATE_NAME:
-                            if(pos == 2 && b != 'R') { // not GPRMC
+                        case STATE_NAME: // any talker, RMC or ZDA
+                            if(pos == 2) {
+                                if(b == 'R') sentence = SENTENCE_RMC;
+                                else if(b == 'Z') sentence = SENTENCE_ZDA;
+                                #if CFG_GPS_STATUS == 1
+                                else if(b == 'G') {
+                                    sentence = SENTENCE_GGA;
+                                    ggaQuality = 0; // empty without a fix on some receivers
+                                    ggaSats = 0;
+                                }
+                                #endif
+                                else {
+                                    state = STATE_ERROR;
+                                    return;
+                                }
+                            }
+                            else if(pos > 2 && b != NAME_TAIL[sentence][pos - 3]) {
+                                state = STATE_ERROR;
+                                return;
+                            }
+                            else if(pos == 5 && sentence == SENTENCE_RMC && zdaSeen) {
+                                --zdaSeen; // skipped, the ZDA of this second is used; not for RMB, RTE
                                 state = STATE_ERROR;
                                 return;
                             }
                             break;
 
                         case STATE_TIME:
-                            if(v > 9) state = STATE_ERROR;
                             gps_datetime.valid = 0;
+                            if(v > 9) { // keep only digits in gps_datetime
+                                state = STATE_ERROR;
+                                return;
+                            }
                             switch(pos) {
                                 case 0: gps_datetime.tenhour    = v; break;
                                 case 1: gps_datetime.hour       = v; break;
@@ -85,21 +302,12 @@ void gps_cycle() {
                                 case 5: gps_datetime.seconds    = v; break;
                             }
                             break;
-
-                        case STATE_DATE:
-                            if(v > 9) state = STATE_ERROR;
-                            switch(pos) {
-                                case 0: gps_datetime.tenday   = v; break;
-                                case 1: gps_datetime.day      = v; break;
-                                case 2: gps_datetime.tenmonth = v; break;
-                                case 3: gps_datetime.month    = v; break;
-                                case 4: gps_datetime.tenyear  = v; break;
-                                case 5: gps_datetime.year     = v; break;
-                            }
-                            break;
                     }
                     if(++pos == 6) {
                         ++state; // next state
+                        #if CFG_GPS_STATUS == 1
+                        if(sentence == SENTENCE_GGA) state = STATE_BETWEEN;
+                        #endif
                         pos = 0;
                     }
                 }
@@ -110,10 +318,50 @@ void gps_cycle() {
 
             case STATE_BETWEEN: // just count commas
                 sum1 ^= b;
+                #if CFG_GPS_CONSENSUS == 1
+                if(pos == 1 && sentence == SENTENCE_RMC && b != ',') status = b;
+                #endif
+                #if CFG_GPS_STATUS == 1
+                if(sentence == SENTENCE_GGA && pos >= GGA_QUALITY && b != ',') {
+                    if(v > 9) {
+                        state = STATE_ERROR;
+                        return;
+                    }
+                    if(pos == GGA_QUALITY) ggaQuality = v;
+                    else ggaSats = ggaSats * 10 + v;
+                }
+                #endif
                 if(b == ',') {
                     ++pos;
-                    if(pos == 8) {
+                    if(pos == DATE_COMMAS[sentence]) {
                         state = STATE_DATE;
+                        pos = (sentence == SENTENCE_ZDA) ? DATE_ZDA : DATE_RMC;
+                        #if CFG_GPS_STATUS == 1
+                        if(sentence == SENTENCE_GGA) state = STATE_TAIL; // rest is skipped
+                        #endif
+                    }
+                }
+                break;
+
+            case STATE_DATE: // pos walks through DATE_FIELDS
+                {
+                    uint8_t f = DATE_FIELDS[pos];
+                    sum1 ^= b;
+                    if(f == DATE_COMMA) {
+                        if(b != ',') {
+                            state = STATE_ERROR;
+                            return;
+                        }
+                    }
+                    else if(v > 9) { // keep only digits in gps_datetime
+                        state = STATE_ERROR;
+                        return;
+                    }
+                    else if(f != DATE_SKIP) {
+                        ((uint8_t *) &gps_datetime)[f] = v;
+                    }
+                    if(DATE_FIELDS[++pos] == DATE_END) {
+                        state = STATE_TAIL;
                         pos = 0;
                     }
                 }
@@ -132,17 +380,33 @@ void gps_cycle() {
 
             case STATE_CHECKSUM:
                 {
-                    uint8_t v = (b > '9') ? (b - 'A' + 10) : (b - '0');
+                    if(l < 6) v = l + 10; // A-F
 
-                    if(pos == 0) {
+                    if(v > 15) {
+                        state = STATE_ERROR;
+                    }
+                    else if(pos == 0) {
                         sum2 = (v << 4);
                         ++pos;
                     }
                     else {
                         sum2 |= v;
                         if(sum1 == sum2) {
-                            gps_datetime.wait = CFG_GPS_CORRECTION;
-                            gps_datetime.valid = 1;
+                            if(sentence == SENTENCE_ZDA) zdaSeen = ZDA_PREFERRED;
+                            #if CFG_GPS_STATUS == 1
+                            if(sentence == SENTENCE_GGA) {
+                                gps_quality = ggaQuality;
+                                gps_sats = ggaSats;
+                                ggaExpire = GGA_EXPIRE;
+                            }
+                            else
+                            #endif
+                            #if CFG_GPS_CONSENSUS == 1
+                            // ZDA has no status, the receiver may send it from its own clock,
+                            // only the consensus guards it
+                            if(sentence == SENTENCE_ZDA || status == 'A')
+                            #endif
+                            gps_fix();
                         }
                         state = STATE_ERROR; // EoS
                     }
@@ -152,10 +416,87 @@ void gps_cycle() {
     }
 }
 
+#endif // CFG_GPS_UBX == 1
+
+static void gps_fix() {
+#if CFG_GPS_CONSENSUS == 1
+    uint16_t s = ((gps_datetime.tenminutes * 10 + gps_datetime.minutes) * 60)
+                 + gps_datetime.tenseconds * 10 + gps_datetime.seconds;
+    uint8_t j, same = 1;
+    for(j = 0; j < sizeof(lastHourDate); ++j) {
+        uint8_t v = ((uint8_t *) &gps_datetime)[GPS_HOUR_DATE + j];
+        if(v != lastHourDate[j]) same = 0;
+        lastHourDate[j] = v;
+    }
+    // the next second of the same hour, or the first of a new one
+    if(s == (lastSecond == 3599 ? 0 : lastSecond + 1) && (same || s == 0)) {
+        if(agree < GPS_AGREE) ++agree;
+    }
+    else {
+        agree = 0; // a jump, or fixes were missing or rejected in between
+    }
+    lastSecond = s;
+    if(agree < GPS_AGREE) return;
+#endif
+#if CFG_GPS_AUTO_CORRECTION == 1
+    // 3/4 old + 1/4 new, a single late sentence moves it only a little
+    gps_latency = ((uint16_t)gps_latency * 3 + burst + 2) >> 2;
+    gps_datetime.wait = (gps_latency < GPS_SECOND) ? GPS_SECOND - gps_latency : 0;
+#else
+    gps_datetime.wait = GPS_WAIT;
+#endif
+    gps_datetime.valid = 1;
+}
+
+void gps_init() {
+#if CFG_GPS_INIT != 0
+    initPending = 1;
+#endif
+}
+
+void gps_cycle() {
+    uint8_t t = RTAIL;
+#if CFG_GPS_INIT != 0
+    // the receiver is up once it talks, its settings are lost with the power
+    if(initPending && t != RHEAD) {
+        initPending = 0;
+        uart_send((__code const uint8_t *) GPS_INIT, GPS_INIT_LEN);
+    }
+#endif
+#if CFG_GPS_AUTO_CORRECTION == 1
+    if(t != RHEAD) {
+        if(idle >= GPS_PAUSE) burst = 0; // output of a new second starts
+        idle = 0;
+    }
+#endif
+    while(t != RHEAD) {
+        gps_byte(RBUF[t]);
+        t = RBUF_NEXT(t);
+        RTAIL = t;
+    }
+}
+
 void gps_cycle10ms() {
+#if CFG_GPS_AUTO_CORRECTION == 1
+    if(idle != 0xFF) ++idle;
+    if(burst != 0xFF) ++burst;
+#endif
+
+#if CFG_GPS_STATUS == 1
+    if(ggaExpire && !--ggaExpire) {
+        gps_quality = GPS_STATUS_NONE;
+        gps_sats = GPS_STATUS_NONE;
+    }
+#endif
+
     if(gps_datetime.valid) {
         if(gps_datetime.wait) {
             --gps_datetime.wait;
         }
+        #if CFG_GPS_PPS == 1
+        else {
+            gps_datetime.valid = 0; // no pulse for it
+        }
+        #endif
     }
 }
@@ -2,6 +2,7 @@
 #define GPS_H
 
 #include <stdint.h>
+#include "config.h"
 
 struct gps_DateTime {
     uint8_t valid;
@@ -23,8 +24,21 @@ struct gps_DateTime {
 
 extern struct gps_DateTime gps_datetime;
 
+#if CFG_GPS_AUTO_CORRECTION == 1
+// 10 ms ticks from the first byte after a pause in the receiver output to the end of the fix, averaged
+extern uint8_t gps_latency;
+#endif
+
+#if CFG_GPS_STATUS == 1
+// from the last GGA, GPS_STATUS_NONE if there was none for a few seconds
+#define GPS_STATUS_NONE 0xFF
+extern uint8_t gps_quality;  // 0 no fix, 1 GPS, 2 DGPS, ...
+extern uint8_t gps_sats;     // satellites in use
+#endif
+
 void gps_init();
 
+// parse all bytes waiting in the uart fifo
 void gps_cycle();
 
 void gps_cycle10ms();
@@ -13,8 +13,11 @@
 #include "ds1302.h"
 #include "led.h"
 #include "gps.h"
+#include "date.h"
 
+#ifndef FOSC
 #define FOSC    11059200
+#endif
 
 // clear wdt
 #define WDT_CLEAR()    (WDT_CONTR |= 1 << 4)
@@ -50,8 +53,49 @@
 #define PM_OFF 0x00
 #define PM_ON  0x20
 
-#define BAUD 9600
+#define BAUD CFG_GPS_BAUD
 #define RXB  P3_7
+#define TXB  P1_3
+
+// soft-uart timing: timer0 in 1T mode, T0_OVERSAMPLE ticks per bit; the timer runs free of
+// the start bit, 3 is the least that samples every bit in its middle third
+#define T0_OVERSAMPLE 3
+#define T0_RATE (BAUD * 1ul * T0_OVERSAMPLE)  // ticks per second
+#define T0_COUNTS ((FOSC + T0_RATE / 2) / T0_RATE)
+
+// timer0_isr (display and uart) may take half of a tick, the rest is left to the main loop;
+// T0_ISR_CLOCKS is its longest path (digit refreshed, byte stored, bit sent) estimated from the
+// code, it has not been measured: take the worst case make sim-profile reports when it changes
+#define T0_ISR_CLOCKS 96
+#define T0_MIN_COUNTS (2 * T0_ISR_CLOCKS)
+#if T0_COUNTS < T0_MIN_COUNTS
+// at 11.0592 MHz up to 19200 baud; a receiver at 38400 (96 clocks a tick) or 115200 (32) has to
+// be set to 19200 or 9600 once, most keep it; 38400 would need FOSC 22.1184 MHz (SYSCLK=22118)
+#error "CFG_GPS_BAUD is too high for FOSC, timer0_isr would not be done within a tick"
+#endif
+
+// sampling must not drift more than 1% from the bit time over a byte
+#if T0_COUNTS * T0_RATE > FOSC + FOSC / 100 || T0_COUNTS * T0_RATE < FOSC - FOSC / 100
+#error "FOSC is not close enough to a multiple of T0_OVERSAMPLE * CFG_GPS_BAUD"
+#endif
+
+// display is multiplexed at about 28.8 kHz, whatever the baud rate
+#define DISP_DIV ((BAUD / 100 * T0_OVERSAMPLE + 144) / 288)  // int, dispdiv is compared with it
+
+#define T1_COUNTS (FOSC / 12 / 100)  // 10 ms, timer1 in 12T mode
+
+// external interrupt 3 on P3.7 (falling edge), not in stc12.h
+__sfr __at (0x8F) INT_CLKO;
+#define EX3  (1 << 5)
+
+#if CFG_GPS_PPS == 1
+// external interrupt 2 on P3.6 (falling edge)
+#define EX2  (1 << 4)
+#endif
+
+// timer0 ticks from int3 at the start bit to the sampling of bit 0: its middle is 1.5 bits
+// after the edge, the first tick comes 0 to 1 tick after int3
+#define RCNT_START ((3 * T0_OVERSAMPLE + 1) / 2)
 
 // display mode states, order is important
 enum display_mode {
@@ -79,18 +123,38 @@ enum display_mode {
     M_DATE_DISP,
     M_WEEKDAY_DISP,
     M_SECONDS_DISP,
+    #if CFG_GPS_STATUS == 1
+    M_SATS_DISP,
+    #endif
     M_SET_OFFSET,
 };
 
 /* ------------------------------------------------------------------------- */
 
 volatile uint8_t timerTicksNow;
+
+#if CFG_GPS_PPS == 1
+volatile __bit ppsEdge;  // set by int2_isr
+void gpsCopyToRtc();
+#endif
+
 // delay may be only tens of ms
 void _delay_ms(uint8_t ms)
 {
     uint8_t stop = timerTicksNow + ms / 10;
     while(timerTicksNow != stop) {
         gps_cycle();
+
+        #if CFG_GPS_PPS == 1
+        // most of the time is spent here, so the write follows the pulse closely
+        if(ppsEdge) {
+            ppsEdge = 0;
+            if(gps_datetime.valid) {
+                gpsCopyToRtc();
+                gps_datetime.valid = 0;
+            }
+        }
+        #endif
     }
 }
 
@@ -115,6 +179,67 @@ struct ds1302_rtc rtc;
 struct ram_config config;
 __bit  configModified;
 
+#if CFG_GPS_HOLDOVER == 1
+uint8_t dsSecond;          // seconds register of the DS1302 as last polled
+uint8_t dsSecondAt;        // timerTicksNow when it changed
+#endif
+
+#if CFG_SOFT_CLOCK == 1
+#define RTC_FREE 0         // rtc runs on timerTicksNow
+#define RTC_TICK 1         // read the DS1302 at its next tick
+#define RTC_READ 2         // read it now, then at its next tick
+
+uint8_t rtcSync = RTC_READ;
+uint8_t rtcSecondAt;       // timerTicksNow at the current second of rtc
+uint8_t rtcDsSecond;       // seconds register of the DS1302 as last polled
+__bit rtcGps;              // rtc was set from GPS in this second
+
+// every 10 ms; the seconds by the timer, the minutes and above from the DS1302 with its phase
+void rtcPoll() {
+    uint8_t s;
+    if(rtcSync == RTC_FREE) {
+        if((uint8_t)(timerTicksNow - rtcSecondAt) < 100)
+            return;
+        if(rtc.tenseconds == 5 && rtc.seconds == 9) {
+            // no GPS for the next minute, the DS1302 has it once it leaves this second
+            rtcSync = RTC_TICK;
+            rtcDsSecond = ((uint8_t *) &rtc)[DS_ADDR_SECONDS];
+            return;
+        }
+        rtcSecondAt += 100;
+        if(++rtc.seconds == 10) {
+            rtc.seconds = 0;
+            ++rtc.tenseconds;
+        }
+        // the timer may be some 100 ms off in a minute, the tick of the DS1302 in this second fixes it
+        if(rtc.tenseconds == 5 && rtc.seconds == 9 && !rtcGps) {
+            rtcSync = RTC_TICK;
+            rtcDsSecond = ds_readbyte(DS_ADDR_SECONDS);
+        }
+        rtcGps = 0;
+        return;
+    }
+
+    if(rtcSync == RTC_READ) {
+        ds_readburst((uint8_t *) &rtc); // read rtc
+        rtcDsSecond = ((uint8_t *) &rtc)[DS_ADDR_SECONDS];
+        rtcSync = RTC_TICK;
+        return;
+    }
+
+    #if CFG_GPS_HOLDOVER == 1
+    s = dsSecond;              // holdoverPoll() reads it while rtcSync is RTC_TICK
+    #else
+    s = ds_readbyte(DS_ADDR_SECONDS);
+    #endif
+    if(s != rtcDsSecond) {
+        ds_readburst((uint8_t *) &rtc); // read rtc
+        rtcSecondAt = timerTicksNow;
+        rtcSync = RTC_FREE;
+    }
+}
+#endif
+
 // to work with current time, only actualy used fields are defined
 struct DateTime {
     uint8_t hour;
@@ -152,6 +277,9 @@ void convertHourToShow(uint8_t hour, struct HourToShow * toShow) {
 }
 
 volatile uint8_t displaycounter;
+#if DISP_DIV > 1
+static uint8_t dispdiv;
+#endif
 uint8_t dbuf[4];             // led display buffer, next state
 uint8_t dbufCur[4];          // led display buffer, current state
 uint8_t dmode = M_NORMAL;    // display mode state
@@ -164,39 +292,70 @@ volatile uint8_t debounce[2];      // switch debounce buffer
 volatile uint8_t switchcount[2];
 
 // uart
-uint8_t RBUF;
-__bit REND;
+__idata uint8_t RBUF[RBUF_SIZE];
+volatile uint8_t RHEAD;
+uint8_t RTAIL;
+volatile uint8_t ROVERRUN;
 static uint8_t RDAT;
 static uint8_t RCNT;
 static uint8_t RBIT;
 static __bit RING;
+#if CFG_GPS_INIT != 0
+volatile uint8_t TLEFT;
+static __code const uint8_t * TPTR;
+static uint8_t TDAT;
+static uint8_t TCNT;
+static uint8_t TBIT;
+#endif
 
-void timer0_isr() __interrupt 1 __using 1
+void timer0_isr() __interrupt(1) __using(1)
 {
     // display refresh ISR
-    // cycle thru digits one at a time
-    uint8_t digit = displaycounter % 4;
-
-    // turn off all digits, set high
-    P3 |= 0x3C;
-
-    // auto dimming, skip lighting for some cycles
-    if (displaycounter % lightval < 4 ) {
-        // fill digits
-        P2 = dbufCur[digit];
-        // turn on selected digit, set low
-        P3 &= ~((0x1 << digit) << 2);
+    #if DISP_DIV > 1
+    if(++dispdiv >= DISP_DIV)
+    #endif
+    {
+        // cycle thru digits one at a time
+        uint8_t digit = displaycounter % 4;
+
+        #if DISP_DIV > 1
+        dispdiv = 0;
+        #endif
+
+        // turn off all digits, set high
+        P3 |= 0x3C;
+
+        // auto dimming, skip lighting for some cycles
+        if (displaycounter % lightval < 4 ) {
+            // fill digits
+            P2 = dbufCur[digit];
+            // turn on selected digit, set low
+            P3 &= ~((0x1 << digit) << 2);
+        }
+        displaycounter++;
     }
-    displaycounter++;
 
     // uart rx
     if(RING) {
         if(--RCNT == 0) {
-            RCNT = 3;                // reset send baudrate counter
+            RCNT = T0_OVERSAMPLE;    // reset send baudrate counter
             if(--RBIT == 0) {
-                RBUF = RDAT;         // save the data to RBUF
-                RING = 0;            // stop receive
-                REND = 1;            // set receive completed flag
+                uint8_t next = RBUF_NEXT(RHEAD);
+                if(next != RTAIL) {
+                    RBUF[RHEAD] = RDAT;  // save the data to RBUF
+                    RHEAD = next;
+                }
+                else {
+                    ++ROVERRUN;      // main loop is too slow, drop the byte
+                }
+                if(RXB) {
+                    RING = 0;        // stop receive
+                }
+                else {
+                    // next start bit came in while the stop bit was expected, int3 has missed it
+                    RCNT = RCNT_START;
+                    RBIT = 9;
+                }
             }
             else {
                 RDAT >>= 1;
@@ -204,14 +363,47 @@ void timer0_isr() __interrupt 1 __using 1
             }
         }
     }
-    else if(!RXB) {
-        RING = 1; // set start receive flag
-        RCNT = 4; // initial receive baudrate counter
-        RBIT = 9; // initial receive bit number (8 data bits + 1 stop bit)
+
+    #if CFG_GPS_INIT != 0
+    // uart tx, T0_OVERSAMPLE ticks per bit
+    if(TLEFT && --TCNT == 0) {
+        TCNT = T0_OVERSAMPLE;
+        if(TBIT == 0) {
+            TDAT = *TPTR;
+            TXB = 0;                 // start bit
+            TBIT = 9;
+        }
+        else if(--TBIT) {
+            TXB = TDAT & 1;          // data bits, lsb first
+            TDAT >>= 1;
+        }
+        else {
+            TXB = 1;                 // stop bit, then the next byte
+            ++TPTR;
+            --TLEFT;
+        }
+    }
+    #endif
+}
+
+void int3_isr() __interrupt(11) __using(1)
+{
+    // start bit, timer0 samples the rest
+    if(!RING && !RXB) {
+        RING = 1;            // set start receive flag
+        RCNT = RCNT_START;   // initial receive baudrate counter
+        RBIT = 9;            // initial receive bit number (8 data bits + 1 stop bit)
     }
 }
 
-void timer1_isr() __interrupt 3 __using 1 {
+#if CFG_GPS_PPS == 1
+void int2_isr() __interrupt(10) __using(1)
+{
+    ppsEdge = 1;
+}
+#endif
+
+void timer1_isr() __interrupt(3) __using(1) {
     // debounce ISR
 
     uint8_t s0 = switchcount[0];
@@ -249,20 +441,21 @@ void timer1_isr() __interrupt 3 __using 1 {
     gps_cycle10ms();
 }
 
-void Timer0Init(void) // ~34.7 us for 9600 UART
+void Timer0Init(void) // 1/T0_OVERSAMPLE bit of the UART, ~34.7 us for 9600
 {
-    TL0 = (uint8_t)(0xFF-(FOSC/3/BAUD/12)); // Initial timer value
-    TH0 = 0xFF;          // Initial timer value
+    AUXR |= 0x80;        // T0x12, timer0 counts FOSC
+    TL0 = (uint8_t)(0x10000 - T0_COUNTS);        // Initial timer value
+    TH0 = (uint8_t)((0x10000 - T0_COUNTS) >> 8); // Initial timer value
     TF0 = 0;             // Clear TF0 flag
     TR0 = 1;             // Timer0 start run
     ET0 = 1;             // enable timer0 interrupt
     EA = 1;              // global interrupt enable
 }
 
-void Timer1Init(void) // 10ms @ 11.0592MHz
+void Timer1Init(void) // 10ms
 {
-    TL1 = 0xD5;          // Initial timer value
-    TH1 = 0xDB;          // Initial timer value
+    TL1 = (uint8_t)(0x10000 - T1_COUNTS);        // Initial timer value
+    TH1 = (uint8_t)((0x10000 - T1_COUNTS) >> 8); // Initial timer value
     TF1 = 0;             // Clear TF1 flag
     TR1 = 1;             // Timer1 start run
     ET1 = 1;             // enable Timer1 interrupt
@@ -272,9 +465,24 @@ void Timer1Init(void) // 10ms @ 11.0592MHz
 void uart_init()
 {
     RING = 0;
-    REND = 0;
+    RHEAD = 0;
+    RTAIL = 0;
     RCNT = 0;
+    INT_CLKO |= EX3;     // start bits by falling edge on RXB
+    #if CFG_GPS_INIT != 0
+    TXB = 1;             // idle
+    #endif
+}
+
+#if CFG_GPS_INIT != 0
+void uart_send(__code const uint8_t * p, uint8_t len)
+{
+    TPTR = p;
+    TCNT = T0_OVERSAMPLE + 1; // a bit time idle first, the stop bit of a previous send may just have begun
+    TBIT = 0;
+    TLEFT = len;
 }
+#endif
 
 uint8_t getkeypress(uint8_t keynum)
 {
@@ -342,100 +550,228 @@ void display(uint8_t d1Always, uint8_t d1, uint8_t d2, uint8_t d3Always, uint8_t
     }
 }
 
-uint8_t daysInMonth(uint8_t y, uint8_t m) {
-    switch(m) {
-        case 4:
-        case 6:
-        case 9:
-        case 11:
-            return 30;
+// in 10 ms ticks
+#define GPS_MAX_DATA_EXPIRE 100ul*60*60*24
+uint32_t gpsDataExpire;
+
+#if CFG_GPS_HOLDOVER == 1
+#if CFG_GPS_SYNC_INTERVAL == 0
+#error "CFG_GPS_HOLDOVER needs CFG_GPS_SYNC_INTERVAL, the DS1302 has to run on its own between writes"
+#endif
 
-        case 2:
-            return (y % 4 == 0 ? 29 : 28);
+#define HOLD_AFTER     60       // seconds without a fix before the trim starts
+#define HOLD_MIN       3600ul   // seconds between two writes for a drift estimate
+#define HOLD_MAX_DRIFT 1000     // 0.1 ppm, larger estimates are taken for errors
+#define HOLD_SECOND    10000000l // 1 s in 0.1 ppm seconds
+#define HOLD_POLL      95       // 10 ms ticks after a tick of the DS1302 before it is polled for the next,
+                                // the timer runs on the RC oscillator and may be some % off
+
+uint32_t holdSeconds;      // DS1302 seconds since the last write from GPS
+int8_t holdTrim;           // seconds trimmed since then
+int32_t holdAcc;           // drift since the last trim, 0.1 ppm seconds
+uint8_t holdFixAge;        // seconds since the last fix, up to HOLD_AFTER
+__bit holdRef;             // a write from GPS to measure against
+
+#if CFG_SOFT_CLOCK == 1
+#define timeChanged() gpsDataExpire = 0, holdRef = 0, rtcSync = RTC_READ
+#else
+#define timeChanged() gpsDataExpire = 0, holdRef = 0
+#endif
+
+// find the ticks of the DS1302, every 10 ms; trim it once a second without GPS
+void holdoverPoll() {
+    uint8_t s;
+    #if CFG_SOFT_CLOCK == 1
+    if(rtcSync != RTC_TICK && (uint8_t)(timerTicksNow - dsSecondAt) < HOLD_POLL) return;
+    #else
+    if((uint8_t)(timerTicksNow - dsSecondAt) < HOLD_POLL) return;
+    #endif
+    s = ds_readbyte(DS_ADDR_SECONDS);
+    if(s == dsSecond) return;
+    dsSecond = s;
+    dsSecondAt = timerTicksNow;
+    ++holdSeconds;
+
+    if(holdFixAge < HOLD_AFTER) {
+        ++holdFixAge;
+        return;
+    }
 
-        default:
-            return 31;
+    // by bcd, the minute is left alone; a write restarts the second of the DS1302 now
+    holdAcc += config.gps_drift;
+    if(holdAcc >= HOLD_SECOND && (s & 0x0F) != 0) {
+        dsSecond = s - 1;
+        --holdTrim;
+    }
+    else if(holdAcc <= -HOLD_SECOND && (s & 0x0F) != 9) {
+        dsSecond = s + 1;
+        ++holdTrim;
     }
+    else {
+        return;
+    }
+    ds_writebyte(DS_ADDR_SECONDS, dsSecond);
+    holdAcc -= (holdAcc > 0) ? HOLD_SECOND : -HOLD_SECOND;
+    #if CFG_SOFT_CLOCK == 1
+    rtcSync = RTC_READ;
+    #endif
 }
 
-uint8_t dayOfWeek(uint8_t y, uint8_t m, uint8_t d) {
-    static const uint8_t OFFSETS[] = { 1, 4, 4, 0, 2, 5, 0, 3, 6, 1, 4, 6 };
-    uint8_t v = y / 4 + d + OFFSETS[m-1];
-    if((y % 4 == 0) && (m == 1 || m == 2)) v -= 1;
-    v += 6 /* correct for 2000-2099 */ + y + 5;
-    v %= 7;
-    return (v + 1);
+// d seconds off at the fix; the DS1302 is written next
+void holdoverMeasure(int16_t d) {
+    if(holdRef && holdSeconds >= HOLD_MIN && d > -100 && d < 100) {
+        // ms the DS1302 is ahead of the fix, without the trims since the last write
+        int32_t ms = (int32_t)(d - holdTrim) * 1000 + (uint8_t)(timerTicksNow - dsSecondAt) * 10;
+        int32_t drift = ms * 10000 / (int32_t)holdSeconds;
+        if(drift > -HOLD_MAX_DRIFT && drift < HOLD_MAX_DRIFT) {
+            // 3/4 old + 1/4 new, the first one as it is
+            config.gps_drift = config.gps_drift ? (config.gps_drift * 3 + (int16_t)drift) / 4 : drift;
+            configModified = 1;
+        }
+    }
+    holdRef = 1;
+    holdSeconds = 0;
+    holdTrim = 0;
+    holdAcc = 0;
+    holdFixAge = 0;
 }
-
-// in 100 ms ticks
-#define GPS_MAX_DATA_EXPIRE 10ul*60*60*24
-uint32_t gpsDataExpire;
-
+#elif CFG_SOFT_CLOCK == 1
+#define timeChanged() gpsDataExpire = 0, rtcSync = RTC_READ
+#else
 #define timeChanged() gpsDataExpire = 0
+#endif
+
+#if CFG_GPS_SYNC_INTERVAL != 0
+// in fixes, i.e. seconds
+#define GPS_SYNC_FIXES ((uint16_t)CFG_GPS_SYNC_INTERVAL * 60)
+#define GPS_SYNC_FAR   0x7FFF
+uint16_t gpsSyncWait;      // fixes until the next forced write
+uint32_t gpsWritesSkipped; // fixes the DS1302 already agreed with
+
+// seconds the DS1302 (as in cur) is ahead of rtc, GPS_SYNC_FAR if the date or hour differ
+int16_t gpsRtcDiff(struct ds1302_rtc * cur) {
+    uint8_t j;
+    for(j = DS_ADDR_HOUR; j <= DS_ADDR_YEAR; ++j) {
+        if(((uint8_t *) cur)[j] != ((uint8_t *) &rtc)[j])
+            return GPS_SYNC_FAR;
+    }
+    return (int16_t)(((cur->tenminutes - rtc.tenminutes) * 10 + cur->minutes - rtc.minutes) * 60)
+        + (cur->tenseconds - rtc.tenseconds) * 10 + cur->seconds - rtc.seconds;
+}
+#endif
 
 void gpsCopyToRtc() {
-    uint8_t y = gps_datetime.tenyear * 10 + gps_datetime.year;
-    uint8_t m = gps_datetime.tenmonth * 10 + gps_datetime.month;
-    uint8_t d = gps_datetime.tenday * 10 + gps_datetime.day;
-    uint8_t h = gps_datetime.tenhour * 10 + gps_datetime.hour;
-
-    if(    m == 0 || m > 12
-        || d == 0 || d > daysInMonth(y, m)
-        || h >= 24
+    struct date_Date dt;
+    int8_t offset = config.time_offset;
+    #if CFG_GPS_SYNC_INTERVAL != 0
+    struct ds1302_rtc cur;
+    int16_t d;
+    uint16_t s;
+    #if CFG_SOFT_CLOCK == 0
+    uint8_t j;
+    #endif
+    #endif
+    dt.year  = gps_datetime.tenyear * 10 + gps_datetime.year;
+    dt.month = gps_datetime.tenmonth * 10 + gps_datetime.month;
+    dt.day   = gps_datetime.tenday * 10 + gps_datetime.day;
+    dt.hour  = gps_datetime.tenhour * 10 + gps_datetime.hour;
+
+    if(    dt.month == 0 || dt.month > 12
+        || dt.day == 0 || dt.day > date_daysInMonth(dt.year, dt.month)
+        || dt.hour >= 24
         || gps_datetime.tenminutes > 5
         || gps_datetime.tenseconds > 5)
     {
         return;
     }
 
-    if(config.time_offset < 0) {
-        uint8_t v = -config.time_offset;
-        if(h < v) {
-            --d;
-            h += 24;
-            if(d == 0) {
-                --m;
-                d = daysInMonth(y, m);
-                if(m == 0) {
-                    --y;
-                    m = 12;
-                }
-            }
-        }
-        h -= v;
-    }
-    else {
-        h += config.time_offset;
-        if(h > 23) {
-            h -= 24;
-            ++d;
-            if(d > daysInMonth(y, m)) {
-                d = 1;
-                ++m;
-                if(m > 12) {
-                    m = 1;
-                    ++y;
+    #if CFG_GPS_PPS == 1 || CFG_GPS_AUTO_CORRECTION == 1
+    // written at the pulse, or the learned wait, that starts the next second
+    if(++gps_datetime.seconds == 10) {
+        gps_datetime.seconds = 0;
+        if(++gps_datetime.tenseconds == 6) {
+            gps_datetime.tenseconds = 0;
+            if(++gps_datetime.minutes == 10) {
+                gps_datetime.minutes = 0;
+                if(++gps_datetime.tenminutes == 6) {
+                    gps_datetime.tenminutes = 0;
+                    ++offset; // next hour
                 }
             }
         }
     }
+    #endif
+
+    date_addHours(&dt, offset);
 
-    rtc.tenyear    = y / 10;
-    rtc.year       = y % 10;
-    rtc.tenmonth   = m / 10;
-    rtc.month      = m % 10;
-    rtc.tenday     = d / 10;
-    rtc.day        = d % 10;
-    rtc.weekday    = dayOfWeek(y, m, d);
+    #if CFG_GPS_SYNC_INTERVAL != 0
+    #if CFG_SOFT_CLOCK == 1
+    ds_readburst((uint8_t *) &cur); // rtc runs on the timer, not a copy of the DS1302
+    #else
+    // read by the main loop at most 100 ms ago, it may be just before a tick like any read
+    for(j = 0; j < sizeof(cur); ++j)
+        ((uint8_t *) &cur)[j] = ((uint8_t *) &rtc)[j];
+    #endif
+    #endif
+
+    rtc.tenyear    = dt.year / 10;
+    rtc.year       = dt.year % 10;
+    rtc.tenmonth   = dt.month / 10;
+    rtc.month      = dt.month % 10;
+    rtc.tenday     = dt.day / 10;
+    rtc.day        = dt.day % 10;
+    rtc.weekday    = date_dayOfWeek(dt.year, dt.month, dt.day);
 
-    rtc.tenhour    = h / 10;
-    rtc.hour       = h % 10;
+    rtc.tenhour    = dt.hour / 10;
+    rtc.hour       = dt.hour % 10;
     rtc.tenminutes = gps_datetime.tenminutes;
     rtc.minutes    = gps_datetime.minutes;
     rtc.tenseconds = gps_datetime.tenseconds;
     rtc.seconds    = gps_datetime.seconds;
 
+    #if CFG_GPS_SYNC_INTERVAL != 0
+    #if CFG_GPS_HOLDOVER == 1
+    holdoverPoll();      // the last tick of the DS1302 as close as possible
+    holdFixAge = 0;
+    #endif
+    // every write restarts the seconds of the DS1302, leave it alone while it keeps up
+    d = gpsRtcDiff(&cur);
+    #if CFG_GPS_HOLDOVER == 1 && CFG_SOFT_CLOCK == 0
+    // the drift needs the second polled just now, the copy may be from before the last tick
+    j = ((uint8_t *) &cur)[DS_ADDR_SECONDS];
+    if(d != GPS_SYNC_FAR && dsSecond != j) {
+        d += ((dsSecond >> 4) - (j >> 4)) * 10 + (dsSecond & 0x0F) - (j & 0x0F);
+        if(dsSecond < j) d += 60;
+    }
+    #endif
+    s = (rtc.tenminutes * 10 + rtc.minutes) * 60 + rtc.tenseconds * 10 + rtc.seconds;
+    if(d == GPS_SYNC_FAR && (s <= CFG_GPS_SYNC_THRESHOLD || s >= 3600 - CFG_GPS_SYNC_THRESHOLD)) {
+        ++gpsWritesSkipped; // at the full hour it may still or already show the other one
+    }
+    else if(gpsSyncWait && d >= -CFG_GPS_SYNC_THRESHOLD && d <= CFG_GPS_SYNC_THRESHOLD) {
+        --gpsSyncWait;
+        ++gpsWritesSkipped;
+    }
+    else {
+        #if CFG_GPS_HOLDOVER == 1
+        holdoverMeasure(d);
+        #endif
+        ds_writeburst((uint8_t const *) &rtc); // write rtc
+        gpsSyncWait = GPS_SYNC_FIXES;
+        #if CFG_GPS_HOLDOVER == 1
+        dsSecond = ((uint8_t *) &rtc)[DS_ADDR_SECONDS];
+        dsSecondAt = timerTicksNow;
+        #endif
+    }
+    #else
     ds_writeburst((uint8_t const *) &rtc); // write rtc
+    #endif
+    #if CFG_SOFT_CLOCK == 1
+    // the fix is at the second, so rtc follows it rather than the DS1302
+    rtcSecondAt = timerTicksNow;
+    rtcSync = RTC_FREE;
+    rtcGps = 1;
+    #endif
     gpsDataExpire = GPS_MAX_DATA_EXPIRE;
 }
 
@@ -452,26 +788,67 @@ int main()
     // init/read ram config
     ds_ram_config_init((uint8_t *) &config);
 
+    // the magic bytes had no crc, nothing out of range may reach the display or the hour arithmetic
+    if(config.temp_offset < -5 || config.temp_offset > 5)
+        config.temp_offset = 0;
+    #if CFG_ALARM == 1
+    if(config.alarm_hour >= 24 || config.alarm_minute >= 60) {
+        config.alarm_hour = 0;
+        config.alarm_minute = 0;
+    }
+    #endif
+    #if CFG_CHIME == 1
+    if(config.chime_hour_start >= 24 || config.chime_hour_stop >= 24) {
+        config.chime_hour_start = 0;
+        config.chime_hour_stop = 0;
+    }
+    #endif
+    if(config.time_offset < -12 || config.time_offset > 14)
+        config.time_offset = 0;
+
+    #if CFG_GPS_AUTO_CORRECTION == 1
+    if(config.gps_latency && config.gps_latency < 100)
+        gps_latency = config.gps_latency;
+    #endif
+
+    #if CFG_GPS_HOLDOVER == 1
+    if(config.gps_drift <= -HOLD_MAX_DRIFT || config.gps_drift >= HOLD_MAX_DRIFT)
+        config.gps_drift = 0;
+    #endif
+
     Timer0Init(); // display refresh
     Timer1Init(); // switch debounce
 
     uart_init();
     gps_init();
 
+    #if CFG_GPS_PPS == 1
+    INT_CLKO |= EX2;     // 1PPS by falling edge on P3.6
+    #endif
+
     // LOOP
     while(1)
     {
         // 100 ms delay
         uint8_t i;
         for(i = 0; i < 10; ++i) {
+            #if CFG_GPS_PPS == 0
             if(gps_datetime.valid && !gps_datetime.wait) {
                 gpsCopyToRtc();
                 gps_datetime.valid = 0;
             }
-            else {
+            else
+            #endif
+            {
                 if(gpsDataExpire > 0)
                     --gpsDataExpire;
             }
+            #if CFG_GPS_HOLDOVER == 1
+            holdoverPoll();
+            #endif
+            #if CFG_SOFT_CLOCK == 1
+            rtcPoll();
+            #endif
             _delay_ms(10);
         }
 
@@ -488,7 +865,9 @@ int main()
                 lightval = 4;
         }
 
+        #if CFG_SOFT_CLOCK == 0
         ds_readburst((uint8_t *) &rtc); // read rtc
+        #endif
         convertNow();
 
         #if CFG_ALARM == 1
@@ -756,9 +1135,20 @@ int main()
                 #endif // CFG_SET_DATE_TIME == 1
 
                 if (getkeypress(S2))
+                #if CFG_GPS_STATUS == 1
+                    dmode = M_SATS_DISP;
+                #else
                     dmode = M_NORMAL;
+                #endif
                 break;
 
+            #if CFG_GPS_STATUS == 1
+            case M_SATS_DISP:
+                if (getkeypress(S2))
+                    dmode = M_NORMAL;
+                break;
+            #endif
+
             case M_NORMAL:
             default:
                 if (count % 10 < 4)
@@ -876,6 +1266,20 @@ int main()
 
                 break;
 
+            #if CFG_GPS_STATUS == 1
+            case M_SATS_DISP:
+                // fix quality, satellites in use; dashes if the receiver sends no GGA
+                if(gps_sats == GPS_STATUS_NONE)
+                    display(1, LED_DASH, LED_BLANK, 1, LED_DASH, LED_DASH);
+                else
+                    display(1, gps_quality, LED_BLANK, 1, ds_int2bcd_tens(gps_sats), ds_int2bcd_ones(gps_sats));
+
+                if(gpsDataExpire)
+                    displayDp(0);
+
+                break;
+            #endif
+
         }
 
         rotateThirdChar();
@@ -884,8 +1288,16 @@ int main()
         dbufCur[2] = dbuf[2];
         dbufCur[3] = dbuf[3];
 
-        // save ram config
-        if(configModified) {
+        #if CFG_GPS_AUTO_CORRECTION == 1
+        // keep the learned latency, but not every jitter of it
+        if((uint8_t)(gps_latency - config.gps_latency + 1) > 2) {
+            config.gps_latency = gps_latency;
+            configModified = 1;
+        }
+        #endif
+
+        // save ram config, once the settings are left
+        if(configModified && dmode >= M_NORMAL && dmode != M_SET_OFFSET) {
             ds_ram_config_write((uint8_t *) &config);
             configModified = 0;
         }
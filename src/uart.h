@@ -2,8 +2,25 @@
 #define UART_H
 
 #include <stdint.h>
+#include "config.h"
 
-extern uint8_t RBUF;
-extern __bit   REND;
+// receive fifo, filled by timer0_isr and drained by gps_cycle()
+// size must be a power of 2, one slot is kept free;
+// RBUF_SIZE + 3 bytes of IRAM in every build (RBUF/REND took 2), RBUF comes out of the
+// indirect RAM the stack grows into: check the stack bytes of make size-report when changing it
+#define RBUF_SIZE 16
+#define RBUF_NEXT(i) (((i) + 1) & (RBUF_SIZE - 1))
+
+extern __idata uint8_t RBUF[RBUF_SIZE];
+extern volatile uint8_t RHEAD;     // written only by the isr
+extern uint8_t RTAIL;              // written only by gps_cycle()
+extern volatile uint8_t ROVERRUN;  // bytes lost because the fifo was full
+
+#if CFG_GPS_INIT != 0
+// transmit, timer0_isr sends len bytes from p; returns at once, not to be called while TLEFT
+void uart_send(__code const uint8_t * p, uint8_t len);
+
+extern volatile uint8_t TLEFT;     // bytes not yet sent completely
+#endif
 
 #endif // UART_H
@@ -0,0 +1,72 @@
+// Cycle benchmark driver for tools/sim_bench.py, runs in ucsim
+// the whole firmware is built in, only its main() is replaced;
+// timers are never started, so no interrupt disturbs the measurements
+//
+
+#define main firmware_main
+#include "../../src/main.c"
+#undef main
+
+static const char BENCH_NMEA[] = "$GPRMC,235959.00,A,5231.01234,N,01323.45678,E,0.021,,311216,,,A*7E\r\n";
+
+static void gpsSet(uint8_t h, uint8_t d, uint8_t m) {
+    gps_datetime.tenhour  = h / 10;
+    gps_datetime.hour     = h % 10;
+    gps_datetime.tenday   = d / 10;
+    gps_datetime.day      = d % 10;
+    gps_datetime.tenmonth = m / 10;
+    gps_datetime.month    = m % 10;
+}
+
+// end marker, the simulation stops here
+void bench_done() {
+}
+
+int main()
+{
+    uint8_t buf[8];
+    uint8_t k;
+    const char * s;
+
+    for(k = 0; k < 4; ++k) {
+        ds_readburst(buf);
+        ds_writeburst(buf);
+        ds_ram_config_init((uint8_t *) &config);
+
+        date_daysInMonth(16, 2 + k);
+        date_dayOfWeek(16, 12, 28 + k);
+
+        flash_d1d2 = k & 1;
+        display_colon = 1;
+        display(0, 1, 2, 1, 3, 4);
+    }
+
+    // plain fix, then rollovers over day, month and year
+    gps_datetime.tenminutes = 5;
+    gps_datetime.minutes = 9;
+    gps_datetime.tenseconds = 5;
+    gps_datetime.seconds = 9;
+    gps_datetime.tenyear = 1;
+    gps_datetime.year = 6;
+
+    config.time_offset = 2;
+    gpsSet(12, 15, 6);
+    gpsCopyToRtc();
+    gpsSet(23, 31, 12);
+    gpsCopyToRtc();
+    config.time_offset = -5;
+    gpsSet(1, 1, 1);
+    gpsCopyToRtc();
+
+    // one sentence through the parser, a full fifo per gps_cycle() call
+    for(s = BENCH_NMEA; *s; ) {
+        while(*s && RBUF_NEXT(RHEAD) != RTAIL) {
+            RBUF[RHEAD] = *s++;
+            RHEAD = RBUF_NEXT(RHEAD);
+        }
+        gps_cycle();
+    }
+
+    bench_done();
+    while(1);
+}
@@ -0,0 +1,78 @@
+#!/usr/bin/env python3
+"""Display regression check with the host emulator.
+
+Every file in the frames directory is a stored run: '# compileopt:' and
+'# emuopts:' lines give the build and the emulator arguments, the other lines
+are the display events 'emu -f' printed. Each run is built (make
+build/host/emu with its COMPILEOPT), repeated, and its display events are
+compared with the stored ones; the check fails with a diff when one differs.
+--update stores the current frames instead, after an intended display change.
+"""
+
+import argparse
+import difflib
+import glob
+import os
+import shlex
+import subprocess
+import sys
+
+EMU = 'build/host/emu'
+DISPLAY = '  display "'
+
+
+def load(path):
+    opts = {'compileopt': '', 'emuopts': ''}
+    head, frames = [], []
+    with open(path) as f:
+        for line in f:
+            if line.startswith('#'):
+                head.append(line)
+                key, _, value = line[1:].partition(':')
+                if key.strip() in opts:
+                    opts[key.strip()] = value.strip()
+            else:
+                frames.append(line)
+    return opts, head, frames
+
+
+def run(make, opts):
+    subprocess.run([make, '-s', EMU, 'COMPILEOPT=' + opts['compileopt']], check=True,
+                   stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+    out = subprocess.run([EMU, '-f'] + shlex.split(opts['emuopts']), check=True,
+                         stdout=subprocess.PIPE, universal_newlines=True).stdout
+    return [line + '\n' for line in out.splitlines() if DISPLAY in line]
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument('--make', default='make')
+    ap.add_argument('--update', action='store_true', help='store the current frames')
+    ap.add_argument('dir')
+    args = ap.parse_args()
+
+    paths = sorted(glob.glob(os.path.join(args.dir, '*.txt')))
+    if not paths:
+        sys.exit('no stored runs in %s' % args.dir)
+
+    failed = 0
+    for path in paths:
+        opts, head, want = load(path)
+        got = run(args.make, opts)
+        if args.update:
+            with open(path, 'w') as f:
+                f.writelines(head + got)
+            print('%s: %d frames stored' % (path, len(got)))
+        elif got != want:
+            failed += 1
+            sys.stdout.writelines(difflib.unified_diff(want, got, path, 'emu -f'))
+        else:
+            print('%s: %d frames ok' % (path, len(got)))
+
+    if failed:
+        sys.exit('%d of %d runs differ, store intended changes with --update (make host-frames-update)'
+                 % (failed, len(paths)))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,84 @@
+// calendar test for src/date.c
+// every hour of 2000-2099 shifted by every UTC offset of the clock (-12..+14, +15 for the
+// hour a PPS fix is taken ahead), checked against timegm()/gmtime() of the C library
+//
+// usage: date_test
+//
+
+#include <stdio.h>
+#include <time.h>
+
+#include "date.h"
+
+#define OFFSET_MIN -12
+#define OFFSET_MAX 15
+#define MAX_REPORT 10
+
+static unsigned long failures;
+
+static void fail(const char * what, int y, int m, int d, int h, int offset, int got, int want) {
+    if(++failures <= MAX_REPORT)
+        printf("%s: 20%02d-%02d-%02d %02d:00 %+d: %d, expected %d\n", what, y, m, d, h, offset, got, want);
+}
+
+int main() {
+    unsigned long cases = 0;
+    struct tm tm = { 0 };
+    int y, m, d, h, offset;
+
+    for(y = 0; y <= 99; ++y) {
+        for(m = 1; m <= 12; ++m) {
+            // the last day of the month is day 0 of the next one
+            tm.tm_year = 100 + y;
+            tm.tm_mon = m;
+            tm.tm_mday = 0;
+            tm.tm_hour = 0;
+            tm.tm_isdst = 0;
+            timegm(&tm);
+            if(date_daysInMonth(y, m) != tm.tm_mday)
+                fail("daysInMonth", y, m, 0, 0, 0, date_daysInMonth(y, m), tm.tm_mday);
+
+            for(d = 1; d <= tm.tm_mday; ++d) {
+                struct tm day = { 0 };
+                time_t t0;
+
+                day.tm_year = 100 + y;
+                day.tm_mon = m - 1;
+                day.tm_mday = d;
+                t0 = timegm(&day);
+                // 1 = Monday .. 7 = Sunday, tm_wday 0 = Sunday
+                if(date_dayOfWeek(y, m, d) != (day.tm_wday ? day.tm_wday : 7))
+                    fail("dayOfWeek", y, m, d, 0, 0, date_dayOfWeek(y, m, d), day.tm_wday ? day.tm_wday : 7);
+
+                for(h = 0; h < 24; ++h) {
+                    for(offset = OFFSET_MIN; offset <= OFFSET_MAX; ++offset) {
+                        struct date_Date dt;
+                        struct tm ref;
+                        time_t t = t0 + (h + offset) * 3600L;
+
+                        gmtime_r(&t, &ref);
+                        dt.year = y;
+                        dt.month = m;
+                        dt.day = d;
+                        dt.hour = h;
+                        date_addHours(&dt, offset);
+                        ++cases;
+
+                        // the clock has two digits for the year, 2099 rolls over to 2000 and back
+                        if(dt.year != ref.tm_year % 100)
+                            fail("addHours year", y, m, d, h, offset, dt.year, ref.tm_year % 100);
+                        else if(dt.month != ref.tm_mon + 1)
+                            fail("addHours month", y, m, d, h, offset, dt.month, ref.tm_mon + 1);
+                        else if(dt.day != ref.tm_mday)
+                            fail("addHours day", y, m, d, h, offset, dt.day, ref.tm_mday);
+                        else if(dt.hour != ref.tm_hour)
+                            fail("addHours hour", y, m, d, h, offset, dt.hour, ref.tm_hour);
+                    }
+                }
+            }
+        }
+    }
+
+    printf("%lu cases, %lu failures\n", cases, failures);
+    return failures ? 1 : 0;
+}
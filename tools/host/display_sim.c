@@ -0,0 +1,87 @@
+// Display decoder for the host tools
+// encoding as in src/led.h: one byte per digit, dp,g,f,e,d,c,b,a, low = lit;
+// the third digit is mounted upside down, main.c swaps its cba and fed bits
+//
+
+#include "display_sim.h"
+
+#include <string.h>
+
+#include "led.h"
+
+#define SEG_A  0x01
+#define SEG_B  0x02
+#define SEG_C  0x04
+#define SEG_D  0x08
+#define SEG_E  0x10
+#define SEG_F  0x20
+#define SEG_G  0x40
+#define SEG_DP 0x80
+
+static const char LEDCHARS[] = "0123456789 -"
+#if CFG_TEMP_UNIT == 'F'
+    "F";
+#else
+    "C";
+#endif
+
+// lit segments of digit pos in normal orientation
+static uint8_t segments(uint8_t const dbuf[4], uint8_t pos) {
+    uint8_t b = dbuf[pos];
+    if(pos == 2)
+        b = (b & 0xC0) | (b & 0x38) >> 3 | (b & 0x07) << 3; // same swap as rotateThirdChar()
+    return ~b;
+}
+
+static char lookup(uint8_t s) {
+    uint8_t i;
+    for(i = 0; i < sizeof(ledtable); ++i) {
+        if((uint8_t)~ledtable[i] == s) return LEDCHARS[i];
+    }
+    return '?';
+}
+
+uint8_t display_sim_text(uint8_t const dbuf[4], char * out) {
+    uint8_t pos, pm = 0;
+
+    for(pos = 0; pos < 4; ++pos) {
+        uint8_t s = segments(dbuf, pos);
+        char c = lookup(s & ~SEG_DP);
+        // PM_ON of main.c lights f of the first digit of an hour, a blank or a 1 in 12 hour mode
+        if(c == '?' && (pos == 0 || pos == 2) && (s & SEG_F)) {
+            c = lookup(s & ~(SEG_DP | SEG_F));
+            if(c != '?') pm |= 1 << pos;
+        }
+        *out++ = c;
+        if(s & SEG_DP) *out++ = '.';
+    }
+    *out = 0;
+    return pm;
+}
+
+void display_sim_art(uint8_t const dbuf[4], char * out) {
+    uint8_t pos;
+    char * l0 = out;
+    char * l1 = out + 17;
+    char * l2 = out + 34;
+
+    memset(out, ' ', 3 * 17);
+    for(pos = 0; pos < 4; ++pos) {
+        uint8_t s = segments(dbuf, pos);
+        char * p0 = l0 + pos * 4;
+        char * p1 = l1 + pos * 4;
+        char * p2 = l2 + pos * 4;
+
+        if(s & SEG_A) p0[1] = '_';
+        if(s & SEG_F) p1[0] = '|';
+        if(s & SEG_G) p1[1] = '_';
+        if(s & SEG_B) p1[2] = '|';
+        if(s & SEG_E) p2[0] = '|';
+        if(s & SEG_D) p2[1] = '_';
+        if(s & SEG_C) p2[2] = '|';
+        if(s & SEG_DP) p2[3] = '.';
+    }
+    l0[16] = '\n';
+    l1[16] = '\n';
+    l2[16] = 0;
+}
@@ -0,0 +1,20 @@
+// Display decoder for the host tools
+// turns the bytes the firmware puts on P2 (dbufCur) back into readable frames
+//
+
+#ifndef DISPLAY_SIM_H
+#define DISPLAY_SIM_H
+
+#include <stdint.h>
+
+// one line, a character per digit followed by '.' when its dp is lit, e.g. 12:34
+// with the colon on is "12.3.4"; a pattern that is not in ledtable becomes '?'
+// out needs at least 9 bytes
+// returns the PM indicator, bit pos set when digit pos (0 or 2) had it lit; it is not in out
+uint8_t display_sim_text(uint8_t const dbuf[4], char * out);
+
+// three lines of segment art, " _ ", "|_|", "|_|." per digit
+// out needs at least 3 * 17 bytes, lines are separated by '\n'
+void display_sim_art(uint8_t const dbuf[4], char * out);
+
+#endif // DISPLAY_SIM_H
@@ -0,0 +1,188 @@
+// DS1302 model for the host tools
+// http://datasheets.maximintegrated.com/en/ds/DS1302.pdf
+//
+
+#include "ds1302_sim.h"
+
+#include <string.h>
+
+#define CMD_RAM    0x40
+#define CMD_READ   0x01
+#define ADDR_BURST 31
+
+#define bcd2int(b) (((b) >> 4) * 10 + ((b) & 0x0F))
+#define int2bcd(i) ((uint8_t)(((i) / 10) << 4 | (i) % 10))
+
+static uint8_t daysInMonth(uint8_t y, uint8_t m) {
+    static const uint8_t DAYS[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    if(m == 2 && y % 4 == 0) return 29;
+    return DAYS[m - 1];
+}
+
+void ds1302_sim_init(struct ds1302_sim * ds) {
+    memset(ds, 0, sizeof(*ds));
+    // power-on state: clock halted, write protected
+    ds->clock[0] = 0x80;
+    ds->clock[3] = 0x01;
+    ds->clock[4] = 0x01;
+    ds->clock[5] = 0x01;
+    ds->clock[7] = 0x80;
+    ds->sclk = 0;
+    ds->io = 1;
+}
+
+static void tick(struct ds1302_sim * ds) {
+    uint8_t y, m, d, hh, mm, ss;
+    ds1302_sim_get(ds, &y, &m, &d, &hh, &mm, &ss);
+
+    if(++ss < 60) {
+        ds->clock[0] = int2bcd(ss);
+        return;
+    }
+    ss = 0;
+    if(++mm == 60) {
+        mm = 0;
+        if(++hh == 24) {
+            hh = 0;
+            ds->clock[5] = ds->clock[5] % 7 + 1;
+            if(++d > daysInMonth(y, m)) {
+                d = 1;
+                if(++m > 12) {
+                    m = 1;
+                    y = (y + 1) % 100;
+                }
+            }
+        }
+    }
+    ds->clock[0] = int2bcd(ss);
+    ds->clock[1] = int2bcd(mm);
+    ds->clock[2] = int2bcd(hh);
+    ds->clock[3] = int2bcd(d);
+    ds->clock[4] = int2bcd(m);
+    ds->clock[6] = int2bcd(y);
+}
+
+void ds1302_sim_advance(struct ds1302_sim * ds, uint32_t ms) {
+    int64_t t = ms;
+
+    if(ds->clock[0] & 0x80) return; // clock halt
+
+    if(ds->drift_ppm) {
+        int64_t acc = ds->drift_acc + (int64_t)ms * ds->drift_ppm;
+        t += acc / 1000000;
+        ds->drift_acc = acc % 1000000;
+    }
+
+    t += ds->subsec;
+    while(t >= 1000) {
+        t -= 1000;
+        tick(ds);
+    }
+    ds->subsec = t < 0 ? 0 : t;
+}
+
+static uint8_t readReg(struct ds1302_sim * ds) {
+    uint8_t addr = (ds->cmd >> 1) & 0x1F;
+    if(addr == ADDR_BURST) addr = ds->bytes;
+
+    if(ds->cmd & CMD_RAM)
+        return addr < sizeof(ds->ram) ? ds->ram[addr] : 0xFF;
+    return addr < sizeof(ds->clock) ? ds->clock[addr] : 0xFF;
+}
+
+static void writeReg(struct ds1302_sim * ds, uint8_t b) {
+    uint8_t addr = (ds->cmd >> 1) & 0x1F;
+    if(addr == ADDR_BURST) addr = ds->bytes;
+
+    if((ds->clock[7] & 0x80) && !(!(ds->cmd & CMD_RAM) && addr == 7))
+        return; // write protected
+
+    if(ds->cmd & CMD_RAM) {
+        if(addr < sizeof(ds->ram)) ds->ram[addr] = b;
+    }
+    else if(addr < sizeof(ds->clock)) {
+        ds->clock[addr] = b;
+        if(addr == 0) ds->subsec = 0; // countdown chain is reset
+        if(ds->bytes == 0) ++ds->clock_writes;
+    }
+}
+
+static void rising(struct ds1302_sim * ds, uint8_t io) {
+    if(ds->driving) return;
+
+    ds->shift |= (io ? 1 : 0) << ds->bits;
+    if(++ds->bits < 8) return;
+
+    if(ds->cmd == 0) {
+        ds->cmd = ds->shift | 0x80; // bit 7 must be 1, keep cmd non-zero
+    }
+    else {
+        writeReg(ds, ds->shift);
+        ++ds->bytes;
+    }
+    ds->bits = 0;
+    ds->shift = 0;
+}
+
+static void falling(struct ds1302_sim * ds) {
+    if(ds->cmd == 0 || !(ds->cmd & CMD_READ)) return;
+
+    if(!ds->driving) {
+        ds->driving = 1;
+        ds->bits = 0;
+    }
+    else if(ds->bits == 8) {
+        ++ds->bytes;
+        ds->bits = 0;
+    }
+    ds->out = (readReg(ds) >> ds->bits) & 1;
+    ++ds->bits;
+}
+
+void ds1302_sim_pins(struct ds1302_sim * ds, uint8_t ce, uint8_t sclk, uint8_t io) {
+    ce = ce ? 1 : 0;
+    sclk = sclk ? 1 : 0;
+
+    if(!ce || !ds->ce) {
+        if(ce) ++ds->transfers;
+        ds->cmd = 0;
+        ds->bits = 0;
+        ds->bytes = 0;
+        ds->shift = 0;
+        ds->driving = 0;
+    }
+    else if(sclk && !ds->sclk) {
+        rising(ds, io);
+    }
+    else if(!sclk && ds->sclk) {
+        falling(ds);
+    }
+
+    ds->ce = ce;
+    ds->sclk = sclk;
+    ds->io = io;
+}
+
+uint8_t ds1302_sim_io(struct ds1302_sim * ds) {
+    return ds->driving ? ds->out : 1;
+}
+
+void ds1302_sim_set(struct ds1302_sim * ds, uint8_t y, uint8_t m, uint8_t d, uint8_t hh, uint8_t mm, uint8_t ss, uint8_t wd) {
+    ds->clock[0] = int2bcd(ss) | (ds->clock[0] & 0x80);
+    ds->clock[1] = int2bcd(mm);
+    ds->clock[2] = int2bcd(hh);
+    ds->clock[3] = int2bcd(d);
+    ds->clock[4] = int2bcd(m);
+    ds->clock[5] = wd;
+    ds->clock[6] = int2bcd(y);
+    ds->subsec = 0;
+}
+
+void ds1302_sim_get(struct ds1302_sim const * ds, uint8_t * y, uint8_t * m, uint8_t * d, uint8_t * hh, uint8_t * mm, uint8_t * ss) {
+    *ss = bcd2int(ds->clock[0] & 0x7F);
+    *mm = bcd2int(ds->clock[1] & 0x7F);
+    *hh = bcd2int(ds->clock[2] & 0x3F);
+    *d  = bcd2int(ds->clock[3] & 0x3F);
+    *m  = bcd2int(ds->clock[4] & 0x1F);
+    *y  = bcd2int(ds->clock[6]);
+}
@@ -0,0 +1,47 @@
+// DS1302 model for the host tools
+// driven at pin level: CE, SCLK and I/O as the firmware bit-bangs them
+//
+
+#ifndef DS1302_SIM_H
+#define DS1302_SIM_H
+
+#include <stdint.h>
+
+struct ds1302_sim {
+    uint8_t clock[8];    // seconds .. write protect, bcd as in the chip
+    uint8_t ram[31];
+
+    uint16_t subsec;     // ms into the current second, reset by a seconds write
+    int32_t  drift_ppm;  // crystal error, positive = runs fast
+    int32_t  drift_acc;
+
+    // serial interface
+    uint8_t ce, sclk, io;
+    uint8_t cmd;
+    uint8_t bits;        // bits shifted in/out of the current byte
+    uint8_t bytes;       // bytes done after the command
+    uint8_t shift;
+    uint8_t driving;     // chip drives I/O (read command)
+    uint8_t out;
+
+    // statistics
+    uint32_t transfers;  // CE high periods
+    uint32_t clock_writes;
+};
+
+void ds1302_sim_init(struct ds1302_sim * ds);
+
+// advance the time keeping by ms milliseconds of real time
+void ds1302_sim_advance(struct ds1302_sim * ds, uint32_t ms);
+
+// new pin levels as driven by the mcu
+void ds1302_sim_pins(struct ds1302_sim * ds, uint8_t ce, uint8_t sclk, uint8_t io);
+
+// level the chip puts on I/O, 1 when not driving (pull-up)
+uint8_t ds1302_sim_io(struct ds1302_sim * ds);
+
+// set/get clock as plain numbers, year 0-99
+void ds1302_sim_set(struct ds1302_sim * ds, uint8_t y, uint8_t m, uint8_t d, uint8_t hh, uint8_t mm, uint8_t ss, uint8_t wd);
+void ds1302_sim_get(struct ds1302_sim const * ds, uint8_t * y, uint8_t * m, uint8_t * d, uint8_t * hh, uint8_t * mm, uint8_t * ss);
+
+#endif // DS1302_SIM_H
@@ -0,0 +1,670 @@
+// Whole-firmware emulator
+// src/main.c built for the host; timers, DS1302 and the GPS receiver are simulated
+// and time runs as fast as the host can go. Prints what happens on the clock.
+//
+// usage: emu [options]
+//   -s "YYYY-MM-DD HH:MM:SS"  start, UTC (default 2016-12-31 20:00:00)
+//   -r "YYYY-MM-DD HH:MM:SS"  DS1302 time at start (default: start in local time)
+//   -d hours                  duration (default 48)
+//   -g from-to                seconds after start with GPS fixes, e.g. 0-3600 or 600- (default always)
+//   -o hours                  config.time_offset
+//   -t XX                     NMEA talker id (default GP)
+//   -z                        send ZDA after each RMC
+//   -n sats                   send GGA in front of RMC with that many satellites in use (0 = no fix),
+//                             below sea level and with a negative geoid separation as in the US
+//   -l ms                     receiver starts sending this long after the second (default 100)
+//   -x bytes                  other sentences the receiver sends in front of RMC
+//   -w seconds                receiver warm-up: status V and the time of its own clock, a day and 17 s off
+//   -e second                 one sentence with status A but an hour off at that second after start
+//   -p ppm                    DS1302 crystal error, positive = runs fast
+//   -m percent                timer1 error (the internal RC oscillator of the mcu), positive = runs fast
+//   -a HH:MM                  switch alarm on for HH:MM
+//   -c start-stop             switch chime on for hours start-stop
+//   -k seconds:S1|S2[:long]   press a button at that many seconds after start, repeatable
+//   -y ms                     exit with 2 if the DS1302 is further off the reference than that while the
+//                             sync indicator is on, from SETTLE_MS after it came on
+//   -f                        print what the display shows whenever it changes, -ff as segment art
+//   -q                        only print the summary
+//
+// The simulated receiver decodes what the clock sends on P1.3 (CFG_GPS_INIT) and accepts
+// PMTK314, PUBX,40 and UBX-CFG-MSG: sentences switched off there are no longer sent, the
+// bytes of -x stand for GLL, GSA, GSV and VTG (with CFG_GPS_UBX for all NMEA output).
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <setjmp.h>
+#include <time.h>
+
+#include <stc12.h>
+#include "host.h"
+#include "config.h"
+#include "ds1302.h"
+#include "gps.h"
+#include "uart.h"
+#include "display_sim.h"
+
+// firmware side, built with -Dmain=firmware_main -Dgps_cycle=host_gps_cycle
+int firmware_main();
+void timer0_isr();
+void timer1_isr();
+#if CFG_GPS_SYNC_INTERVAL != 0
+extern uint32_t gpsWritesSkipped;
+#endif
+#if CFG_GPS_PPS == 1
+void int2_isr();
+#endif
+
+extern struct ram_config config;
+extern __bit configModified;
+extern uint32_t gpsDataExpire;
+extern uint8_t beep;
+extern uint8_t lightval;
+extern uint8_t dbufCur[4];
+extern uint8_t dmode;
+#if CFG_SOFT_CLOCK == 1
+extern struct ds1302_rtc rtc;
+#endif
+#if CFG_ALARM == 1
+extern uint16_t alarmDuration;
+#endif
+#if CFG_CHIME == 1
+extern uint8_t chimeDuration;
+#endif
+
+#define BUZZER P1_5
+
+
+#define KEY_SHORT_MS 200
+#define KEY_LONG_MS  2000
+#define MAX_KEYS     64
+#define SETTLE_MS    60000  // -y: fixes the firmware needs to learn the latency
+
+static jmp_buf done;
+static int quiet;
+
+static time_t startUtc;
+static uint64_t nowMs, endMs;
+static uint64_t gpsFromMs, gpsToMs = (uint64_t)-1;
+
+static int setOffset, offset;
+static int setAlarm, alarmHour, alarmMinute;
+static int setChime, chimeStart, chimeStop;
+static int configured;
+
+struct key {
+    uint64_t atMs;
+    uint32_t holdMs;
+    uint8_t s2;
+};
+static struct key keys[MAX_KEYS];
+static int nkeys;
+static int frames;
+
+static char sentence[1024];
+static const char * talker = "GP";
+static int sendZda;
+static int ggaSats = -1;
+static int gpsLatencyMs = 100;
+static int gpsExtra;
+static uint64_t warmupMs, glitchMs = (uint64_t)-1;
+static double timer1Error, timer1Ms;
+
+#ifndef FOSC
+#define FOSC 11059200
+#endif
+
+// receiver output by the u-blox NMEA message ids, and NAV-TIMEUTC
+#define NMEA_GGA 0
+#define NMEA_GLL 1
+#define NMEA_GSA 2
+#define NMEA_GSV 3
+#define NMEA_RMC 4
+#define NMEA_VTG 5
+#define NMEA_ZDA 8
+#define NMEA_OTHERS (1 << NMEA_GLL | 1 << NMEA_GSA | 1 << NMEA_GSV | 1 << NMEA_VTG)
+static unsigned nmeaOn = 0x1FF;
+#if CFG_GPS_UBX == 1 || CFG_GPS_INIT != 0
+static int timeutcOn = 1;
+#endif
+
+#if CFG_GPS_INIT != 0
+// what the clock sends, sampled at every timer0 tick
+static double txClocks;
+static int txTicks = -1;          // since the start bit
+static uint8_t txByte;
+static uint8_t cmd[256];
+static size_t cmdLen;
+static unsigned long txBytes, txErrors, cmdsAccepted;
+#endif
+static size_t sentenceLen, sentencePos;
+
+// observed state
+static uint8_t lastBuzzer = 1;
+static int lastSynced;
+static long lastDiff = 0x7FFFFFFF;  // ms
+static int lastDay = -1;
+static uint8_t lastDbuf[4];
+#if CFG_SOFT_CLOCK == 1
+static uint64_t softOffMs, softOffSince;  // shown time not the one of the DS1302
+static unsigned long softOffMax;
+#endif
+static long maxDiffSynced;         // ms
+static long maxDiffSettled = -1;   // ms, -1 until SETTLE_MS after the sync indicator came on
+static uint64_t syncedAtMs;
+static long syncLimit = -1;        // ms, -y
+static unsigned long fixes, syncs, expiries, beeps;
+
+static time_t parseTime(const char * s) {
+    struct tm tm;
+    memset(&tm, 0, sizeof(tm));
+    if(sscanf(s, "%d-%d-%d %d:%d:%d", &tm.tm_year, &tm.tm_mon, &tm.tm_mday, &tm.tm_hour, &tm.tm_min, &tm.tm_sec) != 6) {
+        fprintf(stderr, "bad time '%s'\n", s);
+        exit(1);
+    }
+    tm.tm_year -= 1900;
+    tm.tm_mon -= 1;
+    return timegm(&tm);
+}
+
+static time_t modelTime(void) {
+    struct tm tm;
+    uint8_t y, m, d, hh, mm, ss;
+    ds1302_sim_get(&host_ds, &y, &m, &d, &hh, &mm, &ss);
+    memset(&tm, 0, sizeof(tm));
+    tm.tm_year = 100 + y;
+    tm.tm_mon = m - 1;
+    tm.tm_mday = d;
+    tm.tm_hour = hh;
+    tm.tm_min = mm;
+    tm.tm_sec = ss;
+    return timegm(&tm);
+}
+
+static void event(const char * fmt, ...) __attribute__((format(printf, 1, 2)));
+
+static void event(const char * fmt, ...) {
+    va_list ap;
+    char ref[32], rtc[32];
+    time_t t = startUtc + nowMs / 1000;
+    time_t r = modelTime();
+
+    if(quiet) return;
+    strftime(ref, sizeof(ref), "%Y-%m-%d %H:%M:%S", gmtime(&t));
+    strftime(rtc, sizeof(rtc), "%Y-%m-%d %H:%M:%S", gmtime(&r));
+    printf("%9.3f  utc %s  rtc %s  ", nowMs / 1000.0, ref, rtc);
+    va_start(ap, fmt);
+    vprintf(fmt, ap);
+    va_end(ap);
+    putchar('\n');
+}
+
+static void gpsStart(void) {
+    time_t t = startUtc + nowMs / 1000;
+    int warm = nowMs - gpsFromMs < warmupMs;
+    struct tm * tm;
+    uint8_t sum = 0;
+    size_t i;
+
+    if(warm) t -= 24 * 3600 + 17;
+    else if(nowMs / 1000 == glitchMs / 1000) t += 3600;
+    tm = gmtime(&t);
+
+#if CFG_GPS_UBX == 1
+    // UBX-NAV-TIMEUTC
+    static const uint8_t head[] = { 0xB5, 0x62, 0x01, 0x21, 20, 0 };
+    uint8_t * p = (uint8_t *)sentence;
+    uint8_t ck_a = 0, ck_b = 0;
+
+    memset(sentence, 0, 6 + 20);
+    memcpy(p, head, sizeof(head));
+    p[6 + 12] = (tm->tm_year + 1900) & 0xFF;
+    p[6 + 13] = (tm->tm_year + 1900) >> 8;
+    p[6 + 14] = tm->tm_mon + 1;
+    p[6 + 15] = tm->tm_mday;
+    p[6 + 16] = tm->tm_hour;
+    p[6 + 17] = tm->tm_min;
+    p[6 + 18] = tm->tm_sec;
+    p[6 + 19] = warm ? 0x03 : 0x07;  // validTOW, validWKN, validUTC
+    for(i = 2; i < 6 + 20; ++i) {
+        ck_a += p[i];
+        ck_b += ck_a;
+    }
+    p[6 + 20] = ck_a;
+    p[6 + 21] = ck_b;
+    sentenceLen = 6 + 22;
+    if(!timeutcOn) sentenceLen = 0;
+    (void)sum;
+
+    // stands for the NMEA output, never accepted
+    if(nmeaOn & (NMEA_OTHERS | 1 << NMEA_GGA | 1 << NMEA_RMC)) {
+        memmove(sentence + gpsExtra, sentence, sentenceLen);
+        memset(sentence, 'X', gpsExtra);
+        sentenceLen += gpsExtra;
+    }
+#else
+    size_t rmc;
+
+    // stands for GLL, GSA, GSV, VTG, never accepted
+    sentenceLen = 0;
+    if(nmeaOn & NMEA_OTHERS) {
+        memset(sentence, 'X', gpsExtra);
+        sentenceLen = gpsExtra;
+    }
+
+    if(ggaSats >= 0 && (nmeaOn & 1 << NMEA_GGA)) {
+        size_t start = sentenceLen;
+        int sats = warm ? 0 : ggaSats;
+        sentenceLen += snprintf(sentence + sentenceLen, sizeof(sentence) - sentenceLen,
+            "$%.2sGGA,%02d%02d%02d.00,3746.49000,N,12225.16000,W,%d,%02d,0.9,-12.4,M,-30.9,M,,*", talker,
+            tm->tm_hour, tm->tm_min, tm->tm_sec, sats ? 1 : 0, sats);
+        for(i = start + 1; i < sentenceLen - 1; ++i) sum ^= sentence[i];
+        sentenceLen += snprintf(sentence + sentenceLen, sizeof(sentence) - sentenceLen, "%02X\r\n", sum);
+        sum = 0;
+    }
+
+    rmc = sentenceLen;
+    if(nmeaOn & 1 << NMEA_RMC) {
+        sentenceLen += snprintf(sentence + sentenceLen, sizeof(sentence) - sentenceLen,
+            "$%.2sRMC,%02d%02d%02d.00,%c,5231.01234,N,01323.45678,E,0.021,,%02d%02d%02d,,,A*", talker,
+            tm->tm_hour, tm->tm_min, tm->tm_sec, warm ? 'V' : 'A', tm->tm_mday, tm->tm_mon + 1, tm->tm_year % 100);
+        for(i = rmc + 1; i < sentenceLen - 1; ++i) sum ^= sentence[i];
+        sentenceLen += snprintf(sentence + sentenceLen, sizeof(sentence) - sentenceLen, "%02X\r\n", sum);
+    }
+
+    if(sendZda && (nmeaOn & 1 << NMEA_ZDA)) {
+        size_t start = sentenceLen;
+        sentenceLen += snprintf(sentence + sentenceLen, sizeof(sentence) - sentenceLen,
+            "$%.2sZDA,%02d%02d%02d.00,%02d,%02d,%04d,00,00*", talker,
+            tm->tm_hour, tm->tm_min, tm->tm_sec, tm->tm_mday, tm->tm_mon + 1, tm->tm_year + 1900);
+        sum = 0;
+        for(i = start + 1; i < sentenceLen - 1; ++i) sum ^= sentence[i];
+        sentenceLen += snprintf(sentence + sentenceLen, sizeof(sentence) - sentenceLen, "%02X\r\n", sum);
+    }
+#endif
+    sentencePos = 0;
+    ++fixes;
+}
+
+#if CFG_GPS_INIT != 0
+static void nmeaRate(unsigned id, long rate) {
+    if(rate) nmeaOn |= 1u << id;
+    else nmeaOn &= ~(1u << id);
+}
+
+static void nmeaCommand(void) {
+    static const char * const PUBX_NAMES[] = { "GGA", "GLL", "GSA", "GSV", "RMC", "VTG", "", "", "ZDA" };
+    // PMTK314 fields in the order of the u-blox ids, -1 unused
+    static const int PMTK_FIELDS[] = { NMEA_GLL, NMEA_RMC, NMEA_VTG, NMEA_GGA, NMEA_GSA, NMEA_GSV,
+                                       -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, NMEA_ZDA, -1 };
+    char * line = (char *)cmd;
+    char * star;
+    uint8_t sum = 0;
+    size_t i;
+
+    cmd[cmdLen - 2] = 0;  // \r\n
+    star = strchr(line, '*');
+    if(!star) return;
+    for(i = 1; line + i < star; ++i) sum ^= line[i];
+    if(strtoul(star + 1, NULL, 16) != sum) return;
+
+    if(!strncmp(line, "$PMTK314,", 9)) {
+        char * f = line + 9;
+        for(i = 0; i < sizeof(PMTK_FIELDS) / sizeof(PMTK_FIELDS[0]); ++i) {
+            long rate = strtol(f, &f, 10);
+            if(PMTK_FIELDS[i] >= 0) nmeaRate(PMTK_FIELDS[i], rate);
+            if(*f++ != ',') break;
+        }
+    }
+    else if(!strncmp(line, "$PUBX,40,", 9)) {
+        char * f = strchr(line + 9, ',');
+        long rate;
+        if(!f) return;
+        strtol(f + 1, &f, 10);      // ddc
+        rate = strtol(f + 1, &f, 10); // uart1
+        for(i = 0; i < sizeof(PUBX_NAMES) / sizeof(PUBX_NAMES[0]); ++i) {
+            if(PUBX_NAMES[i][0] && !strncmp(line + 9, PUBX_NAMES[i], 3)) nmeaRate(i, rate);
+        }
+    }
+    else {
+        return;
+    }
+    ++cmdsAccepted;
+    event("receiver accepts %s", line);
+}
+
+static void ubxCommand(void) {
+    uint8_t ck_a = 0, ck_b = 0;
+    size_t i;
+
+    for(i = 2; i < cmdLen - 2; ++i) {
+        ck_a += cmd[i];
+        ck_b += ck_a;
+    }
+    if(ck_a != cmd[cmdLen - 2] || ck_b != cmd[cmdLen - 1]) return;
+
+    // UBX-CFG-MSG with one rate
+    if(cmd[2] != 0x06 || cmd[3] != 0x01 || cmd[4] != 3) return;
+    if(cmd[6] == 0xF0) nmeaRate(cmd[7], cmd[8]);
+    else if(cmd[6] == 0x01 && cmd[7] == 0x21) timeutcOn = cmd[8] != 0;
+    else return;
+    ++cmdsAccepted;
+    event("receiver accepts UBX-CFG-MSG %02X %02X rate %d", cmd[6], cmd[7], cmd[8]);
+}
+
+static void gpsCommand(uint8_t b) {
+    ++txBytes;
+    if(cmdLen == 0 && b != '$' && b != 0xB5) return;
+    if(cmdLen == sizeof(cmd)) cmdLen = 0;
+    cmd[cmdLen++] = b;
+
+    if(cmd[0] == '$' && b == '\n' && cmdLen >= 2) {
+        nmeaCommand();
+        cmdLen = 0;
+    }
+    else if(cmd[0] == 0xB5 && cmdLen >= 6 && cmdLen == 8u + (cmd[4] | cmd[5] << 8)) {
+        ubxCommand();
+        cmdLen = 0;
+    }
+}
+
+// 8N1 at 3 timer0 ticks per bit, sampled in the middle of each bit
+static void gpsListen(void) {
+    double tick = (0x10000 - (TH0 << 8 | TL0)) * ((AUXR & 0x80) ? 1 : 12);
+
+    if(!TLEFT && txTicks < 0) {
+        txClocks = 0;
+        return;
+    }
+    txClocks += FOSC / 1000.0;
+    while(txClocks >= tick) {
+        txClocks -= tick;
+        timer0_isr();
+
+        if(txTicks < 0) {
+            if(!P1_3) txTicks = 0;
+        }
+        else if(++txTicks % 3 == 1 && txTicks <= 25) {
+            txByte = txByte >> 1 | (P1_3 ? 0x80 : 0);
+        }
+        else if(txTicks == 28) {
+            if(P1_3) gpsCommand(txByte);
+            else ++txErrors;
+            txTicks = -1;
+        }
+    }
+}
+#endif
+
+// one byte per ms, close to 9600 baud
+static void gpsFeed(void) {
+    if(nowMs % 1000 == gpsLatencyMs && nowMs >= gpsFromMs && nowMs < gpsToMs)
+        gpsStart();
+
+    if(sentencePos < sentenceLen) {
+        uint8_t next = RBUF_NEXT(RHEAD);
+        if(next != RTAIL) {
+            RBUF[RHEAD] = sentence[sentencePos];
+            RHEAD = next;
+        }
+        else {
+            ++ROVERRUN;
+        }
+        ++sentencePos;
+    }
+}
+
+static void keysFeed(void) {
+    uint8_t s1 = 1, s2 = 1;
+    int i;
+
+    for(i = 0; i < nkeys; ++i) {
+        if(nowMs >= keys[i].atMs && nowMs < keys[i].atMs + keys[i].holdMs) {
+            if(keys[i].s2) s2 = 0; else s1 = 0;
+        }
+    }
+    P3_1 = s1;
+    P3_0 = s2;
+}
+
+static void configure(void) {
+    if(setOffset) config.time_offset = offset;
+    if(setAlarm) {
+        config.alarm_on = 1;
+        config.alarm_hour = alarmHour;
+        config.alarm_minute = alarmMinute;
+    }
+    if(setChime) {
+        config.chime_on = 1;
+        config.chime_hour_start = chimeStart;
+        config.chime_hour_stop = chimeStop;
+    }
+    configModified = 1;
+    configured = 1;
+}
+
+static void observe(void) {
+    int synced = gpsDataExpire != 0;
+
+    if(BUZZER != lastBuzzer) {
+        lastBuzzer = BUZZER;
+        if(!BUZZER) ++beeps;
+        event("buzzer %s, beep %d"
+        #if CFG_ALARM == 1
+              ", alarmDuration %d"
+        #endif
+        #if CFG_CHIME == 1
+              ", chimeDuration %d"
+        #endif
+              , BUZZER ? "off" : "on", beep
+        #if CFG_ALARM == 1
+              , alarmDuration
+        #endif
+        #if CFG_CHIME == 1
+              , chimeDuration
+        #endif
+              );
+    }
+
+    if(synced != lastSynced) {
+        lastSynced = synced;
+        if(synced) ++syncs; else ++expiries;
+        syncedAtMs = nowMs;
+        event(synced ? "gps sync indicator on" : "gps sync indicator expired");
+    }
+
+    if(frames && memcmp(dbufCur, lastDbuf, sizeof(lastDbuf))) {
+        char text[9], art[3 * 17];
+        uint8_t pm;
+        memcpy(lastDbuf, dbufCur, sizeof(lastDbuf));
+        pm = display_sim_text(dbufCur, text);
+        event("display \"%s\"%s%s, mode %d", text, pm & 1 ? ", pm" : "", pm & 4 ? ", pm digit 2" : "", dmode);
+        if(frames > 1 && !quiet) {
+            display_sim_art(dbufCur, art);
+            printf("%s\n", art);
+        }
+    }
+
+    if(nowMs % 1000 == 0) {
+        time_t ref = startUtc + nowMs / 1000 + config.time_offset * 3600;
+        time_t rtc = modelTime();
+        long diff = (long)(rtc - ref) * 1000 + host_ds.subsec;
+        struct tm * tm = gmtime(&rtc);
+
+        if(labs(diff - lastDiff) >= 10) {
+            lastDiff = diff;
+            event("rtc - local reference = %+ld ms", diff);
+        }
+        if(synced && labs(diff) > maxDiffSynced) maxDiffSynced = labs(diff);
+        if(synced && nowMs - syncedAtMs >= SETTLE_MS && labs(diff) > maxDiffSettled) maxDiffSettled = labs(diff);
+
+        if(tm->tm_mday != lastDay) {
+            uint8_t wd = tm->tm_wday ? tm->tm_wday : 7;
+            if(lastDay >= 0)
+                event("date rollover, weekday %d%s", host_ds.clock[5], host_ds.clock[5] == wd ? "" : " (WRONG)");
+            lastDay = tm->tm_mday;
+        }
+    }
+}
+
+#if CFG_SOFT_CLOCK == 1
+// the time the firmware keeps against the DS1302 model, seconds to year
+static void observeSoftClock(void) {
+    if(memcmp(&rtc, host_ds.clock, 7)) {
+        if(!softOffSince) softOffSince = nowMs;
+        ++softOffMs;
+        if(nowMs - softOffSince + 1 > softOffMax) softOffMax = nowMs - softOffSince + 1;
+    }
+    else {
+        softOffSince = 0;
+    }
+}
+#endif
+
+// called by the firmware wherever it would call gps_cycle(), i.e. while waiting in _delay_ms()
+void host_gps_cycle() {
+    ++nowMs;
+    ds1302_sim_advance(&host_ds, 1);
+    timer1Ms += 1 + timer1Error;
+    if(timer1Ms >= 10) {
+        timer1Ms -= 10;
+        timer1_isr();
+    }
+#if CFG_GPS_PPS == 1
+    if(nowMs % 1000 == 0 && nowMs >= gpsFromMs && nowMs < gpsToMs) int2_isr();
+#endif
+
+#if CFG_GPS_INIT != 0
+    gpsListen();
+#endif
+    gpsFeed();
+    keysFeed();
+    gps_cycle();
+
+    if(!configured) configure();
+    observe();
+#if CFG_SOFT_CLOCK == 1
+    observeSoftClock();
+#endif
+
+    if(nowMs >= endMs) longjmp(done, 1);
+}
+
+static void usage(const char * name) {
+    fprintf(stderr, "usage: %s [-s start] [-r rtc] [-d hours] [-g from-to] [-o offset] [-t talker] [-z] [-n sats] [-l ms] [-x bytes] [-w seconds] [-e second] [-p ppm] [-m percent] [-a HH:MM] [-c start-stop] [-k seconds:S1|S2[:long]] [-y ms] [-f] [-q]\n", name);
+    exit(1);
+}
+
+int main(int argc, char ** argv) {
+    const char * rtcStart = NULL;
+    int32_t ppm = 0;
+    double hours = 48;
+    struct timespec t0, t1;
+    double wall;
+    time_t r;
+    struct tm * tm;
+    int opt;
+
+    startUtc = parseTime("2016-12-31 20:00:00");
+
+    while((opt = getopt(argc, argv, "s:r:d:g:o:t:zn:l:x:w:e:p:m:a:c:k:y:fq")) != -1) {
+        switch(opt) {
+            case 's': startUtc = parseTime(optarg); break;
+            case 'r': rtcStart = optarg; break;
+            case 'd': hours = atof(optarg); break;
+            case 'g': {
+                char * e;
+                gpsFromMs = strtoull(optarg, &e, 10) * 1000;
+                if(*e != '-') usage(argv[0]);
+                gpsToMs = e[1] ? strtoull(e + 1, NULL, 10) * 1000 : (uint64_t)-1;
+                break;
+            }
+            case 'o': setOffset = 1; offset = atoi(optarg); break;
+            case 't': talker = optarg; break;
+            case 'z': sendZda = 1; break;
+            case 'n': ggaSats = atoi(optarg); break;
+            case 'l': gpsLatencyMs = atoi(optarg) % 1000; break;
+            case 'x': gpsExtra = atoi(optarg); if(gpsExtra > 800) usage(argv[0]); break;
+            case 'w': warmupMs = strtoull(optarg, NULL, 10) * 1000; break;
+            case 'e': glitchMs = strtoull(optarg, NULL, 10) * 1000; break;
+            case 'p': ppm = atoi(optarg); break;
+            case 'm': timer1Error = atof(optarg) / 100; break;
+            case 'a':
+                setAlarm = 1;
+                if(sscanf(optarg, "%d:%d", &alarmHour, &alarmMinute) != 2) usage(argv[0]);
+                break;
+            case 'c':
+                setChime = 1;
+                if(sscanf(optarg, "%d-%d", &chimeStart, &chimeStop) != 2) usage(argv[0]);
+                break;
+            case 'k': {
+                char * e;
+                struct key * k = &keys[nkeys];
+                if(nkeys == MAX_KEYS) usage(argv[0]);
+                k->atMs = strtod(optarg, &e) * 1000;
+                if(strncmp(e, ":S1", 3) && strncmp(e, ":S2", 3)) usage(argv[0]);
+                k->s2 = e[2] == '2';
+                if(!strcmp(e + 3, ":long")) k->holdMs = KEY_LONG_MS;
+                else if(!e[3]) k->holdMs = KEY_SHORT_MS;
+                else usage(argv[0]);
+                ++nkeys;
+                break;
+            }
+            case 'y': syncLimit = atol(optarg); break;
+            case 'f': ++frames; break;
+            case 'q': quiet = 1; break;
+            default: usage(argv[0]);
+        }
+    }
+    endMs = hours * 3600 * 1000;
+
+    ds1302_sim_init(&host_ds);
+    host_ds.drift_ppm = ppm;
+    r = rtcStart ? parseTime(rtcStart) : startUtc + offset * 3600;
+    tm = gmtime(&r);
+    ds1302_sim_set(&host_ds, tm->tm_year % 100, tm->tm_mon + 1, tm->tm_mday, tm->tm_hour, tm->tm_min, tm->tm_sec,
+                   tm->tm_wday ? tm->tm_wday : 7);
+    host_adc[6] = 256;  // light, medium
+    host_adc[7] = 537;  // ntc, about 22 C
+
+    lightval = 4;  // display dimming in timer0_isr divides by it, set by the main loop later
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    if(!setjmp(done))
+        firmware_main();
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    wall = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+
+    printf("simulated:     %.1f h in %.2f s (%.0fx)\n", nowMs / 3600000.0, wall, nowMs / 1000.0 / wall);
+    printf("gps sentences: %lu sent, %u bytes lost in the uart fifo\n", fixes, ROVERRUN);
+    printf("sync:          %lu times on, %lu times expired, max |rtc - reference| while on %ld ms\n",
+           syncs, expiries, maxDiffSynced);
+    if(maxDiffSettled >= 0)
+        printf("               %ld ms from %d s after it came on\n", maxDiffSettled, SETTLE_MS / 1000);
+#if CFG_GPS_AUTO_CORRECTION == 1
+    printf("gps latency:   %u learned, %u stored (10 ms ticks)\n", gps_latency, config.gps_latency);
+#endif
+    printf("buzzer:        %lu times on\n", beeps);
+    printf("ds1302:        %lu transfers, %lu clock writes\n",
+           (unsigned long)host_ds.transfers, (unsigned long)host_ds.clock_writes);
+#if CFG_GPS_INIT != 0
+    printf("gps init:      %lu bytes sent by the clock, %lu framing errors, %lu commands accepted\n",
+           txBytes, txErrors, cmdsAccepted);
+#endif
+#if CFG_GPS_HOLDOVER == 1
+    printf("holdover:      drift %+.1f ppm learned, DS1302 off by %+.1f ppm\n",
+           config.gps_drift / 10.0, (double)host_ds.drift_ppm);
+#endif
+#if CFG_SOFT_CLOCK == 1
+    printf("soft clock:    %.1f s off the DS1302, %lu ms at most\n", softOffMs / 1000.0, softOffMax);
+#endif
+#if CFG_GPS_SYNC_INTERVAL != 0
+    printf("gps sync:      %lu writes skipped, DS1302 within %d s\n", (unsigned long)gpsWritesSkipped, CFG_GPS_SYNC_THRESHOLD);
+#endif
+    if(syncLimit >= 0 && (maxDiffSettled < 0 || maxDiffSettled > syncLimit)) {
+        printf("FAILED: not synced within %ld ms\n", syncLimit);
+        return 2;
+    }
+    return 0;
+}
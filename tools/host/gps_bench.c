@@ -0,0 +1,113 @@
+// NMEA parser replay benchmark
+// src/gps.c built for the host, fed byte by byte through the soft-uart fifo
+//
+// usage: gps_bench [-n passes] file.nmea...
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include <stc12.h>
+#include "gps.h"
+#include "uart.h"
+
+// owned by the soft-uart in main.c on the target
+uint8_t RBUF[RBUF_SIZE];
+volatile uint8_t RHEAD;
+uint8_t RTAIL;
+volatile uint8_t ROVERRUN;
+
+#if CFG_GPS_INIT != 0
+// the receiver configuration is not sent in the replay
+volatile uint8_t TLEFT;
+void uart_send(__code const uint8_t * p, uint8_t len) {
+    (void)p;
+    (void)len;
+}
+#endif
+
+static uint8_t * loadFiles(int argc, char ** argv, size_t * len) {
+    uint8_t * buf = NULL;
+    size_t size = 0;
+    int i;
+
+    for(i = 0; i < argc; ++i) {
+        FILE * f = fopen(argv[i], "rb");
+        size_t n;
+        if(!f) {
+            perror(argv[i]);
+            exit(1);
+        }
+        do {
+            buf = realloc(buf, size + 4096);
+            n = fread(buf + size, 1, 4096, f);
+            size += n;
+        } while(n > 0);
+        fclose(f);
+    }
+
+    *len = size;
+    return buf;
+}
+
+static double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char ** argv) {
+    unsigned long passes = 1000;
+    unsigned long sentences = 0, accepted = 0, rejected;
+    uint8_t * log;
+    size_t len, i;
+    unsigned long p;
+    double t0, t;
+    int opt;
+
+    while((opt = getopt(argc, argv, "n:")) != -1) {
+        switch(opt) {
+            case 'n': passes = strtoul(optarg, NULL, 0); break;
+            default:
+                fprintf(stderr, "usage: %s [-n passes] file.nmea...\n", argv[0]);
+                return 1;
+        }
+    }
+    if(optind >= argc || passes == 0) {
+        fprintf(stderr, "usage: %s [-n passes] file.nmea...\n", argv[0]);
+        return 1;
+    }
+
+    log = loadFiles(argc - optind, argv + optind, &len);
+    gps_init();
+
+    t0 = now();
+    for(p = 0; p < passes; ++p) {
+        for(i = 0; i < len; ++i) {
+            RBUF[RHEAD] = log[i];
+            RHEAD = RBUF_NEXT(RHEAD);
+            gps_cycle();
+
+            if(log[i] == '$') ++sentences;
+            if(gps_datetime.valid) {
+                ++accepted;
+                gps_datetime.valid = 0; // as the main loop does after gpsCopyToRtc()
+            }
+        }
+    }
+    t = now() - t0;
+    rejected = sentences - accepted;
+
+    printf("log:        %zu bytes, %lu passes\n", len, passes);
+    printf("sentences:  %lu per pass\n", sentences / passes);
+    printf("accepted:   %lu per pass (RMC fixes)\n", accepted / passes);
+    printf("rejected:   %lu per pass (other sentences, bad checksum or format)\n", rejected / passes);
+    printf("time:       %.3f s\n", t);
+    printf("throughput: %.0f bytes/s, %.1f ns/byte\n", len * passes / t, t * 1e9 / (len * passes));
+
+    free(log);
+    return 0;
+}
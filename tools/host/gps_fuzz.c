@@ -0,0 +1,258 @@
+// fuzz harness for the GPS parser
+// src/gps.c built for the host, each input fed byte by byte through the soft-uart fifo;
+// aborts when gps_datetime holds a digit > 9 or a fix is accepted without a matching checksum
+//
+// libFuzzer: make host-fuzz (clang)
+// without libFuzzer, built with -DGPS_FUZZ_MAIN:
+//   gps_fuzz [-n inputs] [-s seed] file...
+//   without -n each file is one input (replays a crash or a corpus entry),
+//   with -n that many inputs are cut from the files at random and mutated
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <stc12.h>
+#include "gps.h"
+#include "uart.h"
+
+// owned by the soft-uart in main.c on the target
+uint8_t RBUF[RBUF_SIZE];
+volatile uint8_t RHEAD;
+uint8_t RTAIL;
+volatile uint8_t ROVERRUN;
+
+#if CFG_GPS_INIT != 0
+volatile uint8_t TLEFT;
+void uart_send(__code const uint8_t * p, uint8_t len) {
+    (void)p;
+    (void)len;
+}
+#endif
+
+#define CHECK(cond, what) do { \
+        if(!(cond)) { \
+            fprintf(stderr, "gps_fuzz: %s at byte %lu\n", what, (unsigned long)i); \
+            abort(); \
+        } \
+    } while(0)
+
+static int hexValue(uint8_t c) {
+    if(c >= '0' && c <= '9') return c - '0';
+    if(c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+#if CFG_GPS_UBX == 1
+static const uint8_t UBX_FRAME_HEAD[] = { 0xB5, 0x62, 0x01, 0x21, 20, 0 };
+#define UBX_FRAME 28  // head, payload, checksum
+
+// the frame of a NAV-TIMEUTC ends with d[i], and its Fletcher checksum matches
+static int checksumOk(const uint8_t * d, size_t i) {
+    const uint8_t * f;
+    uint8_t a = 0, b = 0;
+    size_t j;
+
+    if(i + 1 < UBX_FRAME) return 0;
+    f = d + i + 1 - UBX_FRAME;
+    if(memcmp(f, UBX_FRAME_HEAD, sizeof(UBX_FRAME_HEAD)) != 0) return 0;
+    for(j = 2; j < UBX_FRAME - 2; ++j) {
+        a += f[j];
+        b += a;
+    }
+    return a == f[UBX_FRAME - 2] && b == f[UBX_FRAME - 1];
+}
+#else
+// the sentence from the last '$' ends with d[i] as "*HH", HH the XOR of the bytes in between
+static int checksumOk(const uint8_t * d, size_t i) {
+    size_t s = i + 1, star;
+    uint8_t sum = 0;
+    int hi, lo;
+
+    while(s > 0 && d[s - 1] != '$') --s;
+    if(s == 0 || i < s + 2) return 0;
+    star = i - 2;
+    if(d[star] != '*') return 0;
+    hi = hexValue(d[i - 1]);
+    lo = hexValue(d[i]);
+    if(hi < 0 || lo < 0) return 0;
+    for(; s < star; ++s) {
+        if(d[s] == '*') return 0;
+        sum ^= d[s];
+    }
+    return sum == (hi << 4 | lo);
+}
+#endif
+
+int LLVMFuzzerTestOneInput(const uint8_t * data, size_t size) {
+    const uint8_t * digits = &gps_datetime.seconds;
+    size_t i, j;
+
+    // the parser keeps its state between inputs, an illegal byte ends any sentence
+    RBUF[RHEAD] = '\n';
+    RHEAD = RBUF_NEXT(RHEAD);
+    gps_cycle();
+    gps_datetime.valid = 0;
+
+    for(i = 0; i < size; ++i) {
+        RBUF[RHEAD] = data[i];
+        RHEAD = RBUF_NEXT(RHEAD);
+        gps_cycle();
+
+        for(j = 0; j < 12; ++j) CHECK(digits[j] <= 9, "digit > 9");
+        if(gps_datetime.valid) {
+            CHECK(checksumOk(data, i), "fix without a matching checksum");
+            gps_datetime.valid = 0; // as the main loop does after gpsCopyToRtc()
+        }
+    }
+    return 0;
+}
+
+#ifdef GPS_FUZZ_MAIN
+
+#include <unistd.h>
+
+static uint8_t * loadFile(const char * name, size_t * len) {
+    uint8_t * buf = NULL;
+    size_t size = 0, n;
+    FILE * f = fopen(name, "rb");
+
+    if(!f) {
+        perror(name);
+        exit(1);
+    }
+    do {
+        buf = realloc(buf, size + 4096);
+        n = fread(buf + size, 1, 4096, f);
+        size += n;
+    } while(n > 0);
+    fclose(f);
+
+    *len = size;
+    return buf;
+}
+
+// mostly bytes the parser knows, so that mutated sentences get far
+static uint8_t randomByte() {
+    static const char LIKELY[] = "$*,.-0123456789ABCDEFGMNRZ\r\n";
+    if(rand() & 1) return rand() & 0xFF;
+    return LIKELY[rand() % (sizeof(LIKELY) - 1)];
+}
+
+// a correct checksum for the frame or sentence starting at or after p, so that garbage gets accepted
+static void fixChecksum(uint8_t * d, size_t len, size_t p) {
+#if CFG_GPS_UBX == 1
+    uint8_t a = 0, b = 0;
+    size_t j;
+
+    for(; p + UBX_FRAME <= len; ++p) {
+        if(d[p] != UBX_FRAME_HEAD[0]) continue;
+        memcpy(d + p, UBX_FRAME_HEAD, sizeof(UBX_FRAME_HEAD));
+        for(j = 2; j < UBX_FRAME - 2; ++j) {
+            a += d[p + j];
+            b += a;
+        }
+        d[p + UBX_FRAME - 2] = a;
+        d[p + UBX_FRAME - 1] = b;
+        return;
+    }
+#else
+    static const char HEX[] = "0123456789ABCDEF";
+    uint8_t sum = 0;
+
+    while(p < len && d[p] != '$') ++p;
+    for(++p; p < len && d[p] != '*' && d[p] != '$'; ++p) sum ^= d[p];
+    if(p + 2 < len && d[p] == '*') {
+        d[p + 1] = HEX[sum >> 4];
+        d[p + 2] = HEX[sum & 0x0F];
+    }
+#endif
+}
+
+#define MAX_INPUT 512
+
+static size_t mutate(uint8_t * d, size_t len) {
+    int k = 1 + rand() % 8;
+
+    while(k--) {
+        size_t p = len ? (size_t)rand() % len : 0;
+        switch(rand() % 4) {
+            case 0: // replace
+                if(len) d[p] = randomByte();
+                break;
+            case 1: // insert
+                if(len < MAX_INPUT) {
+                    memmove(d + p + 1, d + p, len - p);
+                    d[p] = randomByte();
+                    ++len;
+                }
+                break;
+            case 2: // delete
+                if(len) {
+                    memmove(d + p, d + p + 1, len - p - 1);
+                    --len;
+                }
+                break;
+            case 3:
+                fixChecksum(d, len, p);
+                break;
+        }
+    }
+    return len;
+}
+
+int main(int argc, char ** argv) {
+    unsigned long inputs = 0, n;
+    unsigned int seed = 1;
+    uint8_t ** files;
+    size_t * lens;
+    int count, opt, f;
+
+    while((opt = getopt(argc, argv, "n:s:")) != -1) {
+        switch(opt) {
+            case 'n': inputs = strtoul(optarg, NULL, 0); break;
+            case 's': seed = strtoul(optarg, NULL, 0); break;
+            default:
+                fprintf(stderr, "usage: %s [-n inputs] [-s seed] file...\n", argv[0]);
+                return 1;
+        }
+    }
+    count = argc - optind;
+    if(count <= 0) {
+        fprintf(stderr, "usage: %s [-n inputs] [-s seed] file...\n", argv[0]);
+        return 1;
+    }
+
+    files = malloc(count * sizeof(*files));
+    lens = malloc(count * sizeof(*lens));
+    for(f = 0; f < count; ++f) files[f] = loadFile(argv[optind + f], &lens[f]);
+    gps_init();
+
+    if(inputs == 0) {
+        for(f = 0; f < count; ++f) LLVMFuzzerTestOneInput(files[f], lens[f]);
+        printf("%d inputs ok\n", count);
+    }
+    else {
+        uint8_t buf[MAX_INPUT];
+        srand(seed);
+        for(n = 0; n < inputs; ++n) {
+            size_t len, from;
+            f = rand() % count;
+            len = 1 + rand() % (MAX_INPUT / 2);
+            if(len > lens[f]) len = lens[f];
+            from = (lens[f] > len) ? (size_t)rand() % (lens[f] - len + 1) : 0;
+            memcpy(buf, files[f] + from, len);
+            len = mutate(buf, len);
+            LLVMFuzzerTestOneInput(buf, len);
+        }
+        printf("%lu inputs ok (seed %u)\n", inputs, seed);
+    }
+
+    for(f = 0; f < count; ++f) free(files[f]);
+    free(files);
+    free(lens);
+    return 0;
+}
+
+#endif // GPS_FUZZ_MAIN
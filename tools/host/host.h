@@ -0,0 +1,16 @@
+// Shared state of the host builds: models behind the special function registers
+//
+
+#ifndef HOST_H
+#define HOST_H
+
+#include <stdint.h>
+#include "ds1302_sim.h"
+
+// DS1302 on P1.0-P1.2
+extern struct ds1302_sim host_ds;
+
+// 10-bit value the ADC returns per channel
+extern uint16_t host_adc[8];
+
+#endif // HOST_H
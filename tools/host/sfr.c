@@ -0,0 +1,56 @@
+// Special function registers for the host builds
+// plain registers are memory, the DS1302 pins and the ADC are backed by models
+//
+
+#include <stc12.h>
+#include "host.h"
+
+#define ADC_FLAG    0x10
+#define ADC_START   0x08
+
+// reset values
+uint8_t P1 = 0xFF, P2 = 0xFF, P3 = 0xFF;
+uint8_t P1M0, P1M1, P1ASF, ADC_RES, ADC_RESL, WDT_CONTR;
+uint8_t TL0, TH0, TL1, TH1, AUXR;
+__bit   TF0, TR0, ET0, TF1, TR1, ET1, EA;
+__bit   P1_3 = 1, P1_4 = 1, P1_5 = 1, P1_6 = 1, P1_7 = 1;
+__bit   P3_0 = 1, P3_1 = 1, P3_2 = 1, P3_3 = 1, P3_4 = 1, P3_5 = 1, P3_6 = 1, P3_7 = 1;
+
+struct ds1302_sim host_ds;
+uint16_t host_adc[8];
+
+static uint8_t ds_ce = 1, ds_sclk = 1;
+static uint8_t ds_io_latch = 1;  // what the mcu drives, open-drain
+static uint8_t ds_io_view = 1;   // what the last access saw
+static uint8_t ds_io_seen = 1;
+static uint8_t adc_contr;
+
+uint8_t * host_sfr(uint8_t addr) {
+    // a write through the returned pointer is only seen on the next access;
+    // the firmware changes one pin per access, so no edge gets lost
+    if(ds_io_view != ds_io_seen) ds_io_latch = ds_io_view;
+    ds1302_sim_pins(&host_ds, ds_ce, ds_sclk, ds_io_latch);
+    ds_io_seen = ds_io_view;
+
+    switch(addr) {
+        case 0x90:
+            return &ds_ce;
+
+        case 0x91:
+            ds_io_view = ds_io_seen = ds_io_latch & ds1302_sim_io(&host_ds);
+            return &ds_io_view;
+
+        case 0x92:
+            return &ds_sclk;
+
+        case 0xBC:
+            if(adc_contr & ADC_START) { // conversion is done by the next access
+                uint16_t v = host_adc[adc_contr & 0x07];
+                ADC_RES = v >> 2;
+                ADC_RESL = v & 0x03;
+                adc_contr = (adc_contr & ~ADC_START) | ADC_FLAG;
+            }
+            return &adc_contr;
+    }
+    return 0;
+}
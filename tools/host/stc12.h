@@ -0,0 +1,43 @@
+// Host stand-in for sdcc's <stc12.h>
+// lets the firmware sources build with the native compiler for the tools in this directory
+//
+
+#ifndef HOST_STC12_H
+#define HOST_STC12_H
+
+#include <stdint.h>
+
+// sdcc keywords
+#define __bit           uint8_t
+#define __code
+#define __data
+#define __idata
+#define __xdata
+#define __sfr           uint8_t
+#define __sbit          uint8_t
+#define __at(a)
+#define __interrupt(n)
+#define __using(n)
+
+// _nop_ is spelled "__asm nop __endasm;" in the sources
+#define __asm           ((void)0
+#define nop
+#define __endasm        )
+
+// special function registers, plain memory (sfr.c)
+extern uint8_t P1, P2, P3;
+extern uint8_t P1M0, P1M1, P1ASF, ADC_RES, ADC_RESL, WDT_CONTR;
+extern uint8_t TL0, TH0, TL1, TH1, AUXR;
+extern __bit   TF0, TR0, ET0, TF1, TR1, ET1, EA;
+extern __bit   P1_3, P1_4, P1_5, P1_6, P1_7;
+extern __bit   P3_0, P3_1, P3_2, P3_3, P3_4, P3_5, P3_6, P3_7;
+
+// registers with side effects, every access goes through the model first
+uint8_t * host_sfr(uint8_t addr);
+
+#define P1_0            (*host_sfr(0x90))
+#define P1_1            (*host_sfr(0x91))
+#define P1_2            (*host_sfr(0x92))
+#define ADC_CONTR       (*host_sfr(0xBC))
+
+#endif // HOST_STC12_H
@@ -0,0 +1,243 @@
+// Soft-uart receiver simulation
+// src/main.c built for the host; int3_isr sees the falling edges of a synthetic RX
+// waveform on P3.7 and timer0_isr samples it at the tick Timer0Init programs,
+// the bytes they put in the fifo are checked against what was sent
+//
+// usage: uart_sim [options]
+//   -b baud          baud rate of the sender without error (default CFG_GPS_BAUD)
+//   -m percent       sender baud rate error, or a sweep from:to:step (default -6:6:0.5)
+//   -j clocks        edge jitter, every bit edge moves up to +-clocks (default 0)
+//   -l clocks        isr latency, every tick is sampled up to clocks late (default 0)
+//   -g bits          idle time between bytes (default 0, back to back as a receiver sends a sentence)
+//   -n bytes         bytes per run (default 20000)
+//   -r seed          random seed
+//   -t               transmit instead (CFG_GPS_INIT): timer0_isr sends random bytes on P1.3, a
+//                    receiver with the baud rate error of -m decodes them, -j and -g are not used
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <stc12.h>
+#include "host.h"
+#include "uart.h"
+#include "config.h"
+
+#ifndef FOSC
+#define FOSC 11059200
+#endif
+
+// firmware side, built with -Dmain=firmware_main -Dgps_cycle=host_gps_cycle
+void timer0_isr();
+void int3_isr();
+void Timer0Init(void);
+void uart_init();
+
+#define TXB P1_3
+
+extern uint8_t lightval;
+
+#define RXB P3_7
+
+static double baud = CFG_GPS_BAUD;
+static double jitter, latency, gap;
+static unsigned long bytes = 20000;
+
+struct frame {
+    double edge[11];   // start of start bit, data bits, stop bit; end of stop bit
+    uint8_t value;
+    uint8_t received;  // bytes the receiver delivered while this frame was on the line
+    uint8_t ok;
+};
+
+// the receiver only polls in _delay_ms, not used here
+void host_gps_cycle() {
+}
+
+static double uniform(double range) {
+    return range * (2.0 * rand() / RAND_MAX - 1.0);
+}
+
+static void frameNext(struct frame * f, double start, double bit) {
+    int i;
+    f->value = rand();
+    f->received = 0;
+    f->ok = 0;
+    for(i = 0; i < 11; ++i)
+        f->edge[i] = start + i * bit + (i ? uniform(jitter) : 0);
+}
+
+static uint8_t frameLevel(struct frame const * f, double t) {
+    int i;
+    if(t < f->edge[0]) return 1;
+    for(i = 0; i < 10 && t >= f->edge[i + 1]; ++i);
+    if(i == 0) return 0;
+    if(i == 9 || i == 10) return 1;
+    return (f->value >> (i - 1)) & 1;
+}
+
+// clocks per timer0 tick, 16-bit auto-reload
+static double tickClocks(void) {
+    return (0x10000 - (TH0 << 8 | TL0)) * ((AUXR & 0x80) ? 1 : 12);
+}
+
+// byte error rate with the sender off by mismatch percent
+static double run(double mismatch, unsigned long * errors, unsigned long * extra) {
+    double bit = (double)FOSC / (baud * (1 + mismatch / 100));
+    double tick = tickClocks();
+    double t;
+    struct frame prev, cur;
+    unsigned long sent = 0, n;
+    uint8_t level = 1;
+
+    uart_init();
+    ROVERRUN = 0;
+    *errors = *extra = 0;
+
+    memset(&prev, 0, sizeof(prev));
+    prev.received = 1;
+    prev.ok = 1;
+    frameNext(&cur, 10 * bit, bit);
+
+    for(n = 0; sent < bytes; ++n) {
+        t = n * tick + (latency ? latency * rand() / RAND_MAX : 0);
+
+        if(t >= cur.edge[10] + gap * bit) {
+            if(!(prev.received == 1 && prev.ok)) ++*errors;
+            if(prev.received > 1) *extra += prev.received - 1;
+            prev = cur;
+            ++sent;
+            frameNext(&cur, cur.edge[10] + gap * bit, bit);
+        }
+
+        // a falling edge since the last tick raised int3 before this tick
+        RXB = frameLevel(&cur, t);
+        if(level && !RXB) int3_isr();
+        level = RXB;
+        timer0_isr();
+
+        if(RTAIL != RHEAD) {
+            // the stop bit of a late byte may already be in the next frame
+            struct frame * f = (t - cur.edge[0] < 5 * bit) ? &prev : &cur;
+            if(f->received++ == 0) f->ok = RBUF[RTAIL] == f->value;
+            RTAIL = RBUF_NEXT(RTAIL);
+        }
+    }
+    return (double)*errors / sent;
+}
+
+#if CFG_GPS_INIT != 0
+struct edge {
+    double t;
+    uint8_t level;
+};
+
+static struct edge * edges;
+static size_t nedges, edgeAt;
+
+static uint8_t levelAt(double t) {
+    while(edgeAt + 1 < nedges && edges[edgeAt + 1].t <= t) ++edgeAt;
+    return edges[edgeAt].level;
+}
+
+// byte error rate of what timer0_isr sends, seen by a receiver off by mismatch percent
+static double runTx(double mismatch, unsigned long * errors, unsigned long * extra) {
+    double bit = (double)FOSC / (baud * (1 + mismatch / 100));
+    double tick = tickClocks();
+    double t = 0, start;
+    uint8_t * data = malloc(bytes);
+    unsigned long sent = 0, got = 0, n, i;
+
+    uart_init();
+    *errors = *extra = 0;
+    for(i = 0; i < bytes; ++i) data[i] = rand();
+
+    // the waveform, as edges
+    nedges = edgeAt = 0;
+    edges = realloc(edges, (bytes * 10 + 2) * sizeof(*edges));
+    edges[nedges].t = 0;
+    edges[nedges++].level = TXB;
+    for(n = 0; sent < bytes || TLEFT; ++n) {
+        if(!TLEFT && sent < bytes) {
+            uint8_t len = bytes - sent > 255 ? 255 : bytes - sent;
+            uart_send(data + sent, len);
+            sent += len;
+        }
+        t = n * tick + (latency ? latency * rand() / RAND_MAX : 0);
+        timer0_isr();
+        if(TXB != edges[nedges - 1].level) {
+            edges[nedges].t = t;
+            edges[nedges++].level = TXB;
+        }
+    }
+
+    // a receiver samples in the middle of its bits from the falling edge of the start bit
+    for(i = 1; i < nedges && got < bytes; ++i) {
+        uint8_t b = 0;
+        int k;
+        if(edges[i].level) continue;
+        start = edges[i].t;
+        edgeAt = i;
+        for(k = 0; k < 8; ++k) b |= levelAt(start + (1.5 + k) * bit) << k;
+        if(!levelAt(start + 9.5 * bit) || b != data[got]) ++*errors;
+        ++got;
+        while(i + 1 < nedges && edges[i + 1].t <= start + 9.5 * bit) ++i;
+    }
+    *errors += bytes - got;
+    free(data);
+    return (double)*errors / bytes;
+}
+#endif
+
+static void usage(const char * name) {
+    fprintf(stderr, "usage: %s [-b baud] [-m percent|from:to:step] [-j clocks] [-l clocks] [-g bits] [-n bytes] [-r seed] [-t]\n", name);
+    exit(1);
+}
+
+int main(int argc, char ** argv) {
+    double from = -6, to = 6, step = 0.5, m;
+    int opt, tx = 0;
+
+    while((opt = getopt(argc, argv, "b:m:j:l:g:n:r:t")) != -1) {
+        switch(opt) {
+            case 'b': baud = atof(optarg); break;
+            case 'm':
+                if(sscanf(optarg, "%lf:%lf:%lf", &from, &to, &step) != 3) {
+                    from = to = atof(optarg);
+                    step = 1;
+                }
+                if(step <= 0) usage(argv[0]);
+                break;
+            case 'j': jitter = atof(optarg); break;
+            case 'l': latency = atof(optarg); break;
+            case 'g': gap = atof(optarg); break;
+            case 'n': bytes = strtoul(optarg, NULL, 10); break;
+            case 'r': srand(atoi(optarg)); break;
+            case 't': tx = 1; break;
+            default: usage(argv[0]);
+        }
+    }
+
+    lightval = 4;  // display dimming divides by it, set by the main loop on the target
+    Timer0Init();
+
+    printf("tick:      %.0f clocks, %.3f ticks per bit at %.0f baud\n", tickClocks(), FOSC / baud / tickClocks(), baud);
+    printf("jitter:    +-%.0f clocks, isr latency 0-%.0f clocks, gap %.1f bits, %lu bytes per run\n",
+           jitter, latency, gap, bytes);
+    printf("%9s %9s %9s %10s\n", "mismatch", "errors", "extra", "error rate");
+    for(m = from; m <= to + step / 2; m += step) {
+        unsigned long errors, extra;
+        double ber;
+#if CFG_GPS_INIT != 0
+        if(tx) ber = runTx(m, &errors, &extra);
+        else
+#else
+        if(tx) usage(argv[0]);
+#endif
+        ber = run(m, &errors, &extra);
+        printf("%+8.2f%% %9lu %9lu %10.2e\n", m, errors, extra, ber);
+    }
+    return 0;
+}
@@ -0,0 +1,131 @@
+#!/usr/bin/env python3
+"""Per-function cycle benchmark of the firmware, measured in ucsim (s51).
+
+Runs tools/bench/bench.c, which calls the functions of the main-loop path
+with representative arguments, and measures every call from the function's
+entry to its ret. Entries are taken from the linker's .map, the rets from the
+.rst listing of the module the .map names for the function (sdcc writes one
+per module, next to the .map). Results are compared with a stored baseline:
+the run fails if the average or worst case of a function grows by more than
+the tolerance, or if the baseline file or a function in it is missing. A
+baseline without any numbers (as committed before anyone measured) only
+reports, the check starts with the first --update. --update writes the
+current results as the new baseline.
+"""
+
+import argparse
+import os
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import ucsim
+
+FUNCTIONS = ['ds_readburst', 'ds_writeburst', 'ds_ram_config_init', 'gpsCopyToRtc',
+             'date_dayOfWeek', 'date_daysInMonth', 'display', 'gps_cycle']
+DONE = 'bench_done'
+RET_CLKS = 24           # ret is 2 machine cycles
+
+
+def load_baseline(path):
+    base = {}
+    with open(path) as f:
+        for line in f:
+            line = line.split('#')[0].split()
+            if len(line) == 3:
+                base[line[0]] = (float(line[1]), int(line[2]))
+    return base
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument('--s51', default='s51')
+    ap.add_argument('--tolerance', type=float, default=2.0, help='allowed growth in percent')
+    ap.add_argument('--update', action='store_true', help='store results as the new baseline')
+    ap.add_argument('ihx')
+    ap.add_argument('map')
+    ap.add_argument('baseline')
+    args = ap.parse_args()
+
+    if not args.update and not os.path.exists(args.baseline):
+        sys.exit('no baseline in %s, run with --update to create it' % args.baseline)
+
+    syms = ucsim.map_symbols(args.map)
+    listings = {}
+    entries, exits = {}, {}
+    for name in FUNCTIONS + [DONE]:
+        if name not in syms:
+            sys.exit('%s not found in %s' % (name, args.map))
+        addr, module = syms[name]
+        rst = os.path.join(os.path.dirname(args.map), module + '.rst')
+        if rst not in listings:
+            if not os.path.exists(rst):
+                sys.exit('%s not found, listing of module %s' % (rst, module))
+            listings[rst] = ucsim.rst_functions(rst)
+        f = listings[rst].get(name)
+        if not f or not f['ret']:
+            sys.exit('no ret of %s in %s' % (name, rst))
+        if f['entry'] != addr:
+            sys.exit('%s is at 0x%04x in %s but 0x%04x in %s, stale listing?' % (name, addr, args.map, f['entry'], rst))
+        entries[addr] = name
+        for a in f['ret']:
+            exits[a] = name
+
+    sim = ucsim.Sim(args.s51, args.ihx)
+    for a in list(entries) + list(exits):
+        sim.cmd('break 0x%x' % a)
+
+    stats = dict((name, []) for name in FUNCTIONS)
+    started = {}
+    try:
+        while True:
+            pc, clks = sim.run_to_break()
+            if entries.get(pc) == DONE:
+                break
+            if pc in entries:
+                started[entries[pc]] = clks
+            elif pc in exits and exits[pc] in started:
+                name = exits[pc]
+                stats[name].append(clks - started.pop(name) + RET_CLKS)
+    finally:
+        sim.close()
+
+    results = {}
+    for name in FUNCTIONS:
+        s = stats[name]
+        if not s:
+            sys.exit('%s was never measured' % name)
+        results[name] = (float(sum(s)) / len(s), max(s))
+
+    if args.update:
+        with open(args.baseline, 'w') as f:
+            f.write('# function  avg-clks  max-clks, written by tools/sim_bench.py --update\n')
+            for name in FUNCTIONS:
+                f.write('%-20s %10.1f %8d\n' % (name, results[name][0], results[name][1]))
+        print('baseline written to %s' % args.baseline)
+
+    base = load_baseline(args.baseline)
+    limit = 1.0 + args.tolerance / 100.0
+    failed = []
+    print('%-20s %6s %10s %8s %10s %8s' % ('function', 'calls', 'avg', 'max', 'base avg', 'base max'))
+    for name in FUNCTIONS:
+        avg, mx = results[name]
+        b = base.get(name)
+        mark = ''
+        if not b:
+            mark = '  NO BASELINE'
+            failed.append(name)
+        elif avg > b[0] * limit or mx > b[1] * limit:
+            mark = '  REGRESSION'
+            failed.append(name)
+        print('%-20s %6d %10.1f %8d %10s %8s%s' % (name, len(stats[name]), avg, mx,
+              '%.1f' % b[0] if b else '-', b[1] if b else '-', mark))
+    print('(clocks on the simulated 12T core)')
+
+    if not base:
+        print('no numbers in %s yet, nothing checked; store them with --update (make sim-bench-update)' % args.baseline)
+    elif failed:
+        sys.exit('%d function(s) without a baseline or slower than it by more than %.1f%%' % (len(failed), args.tolerance))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,113 @@
+#!/usr/bin/env python3
+"""ISR cycle budget of the firmware, measured in ucsim (s51).
+
+Breakpoints are put on the timer0/timer1 interrupt vectors and on every reti
+of timer0_isr/timer1_isr/int3_isr (taken from build/main.rst). Each ISR run is
+measured from its vector to its reti, so the ljmp in the vector is included.
+While running, P3.7 (RXB) is driven with NMEA bytes at 3 timer0 ticks per bit,
+so the soft-uart receive path is part of the measurement.
+
+The start bit is caught by the STC15's INT3, which ucsim does not have. On a
+falling edge of the waveform the timer0 interrupt that just started is sent to
+the INT3 vector instead; that tick is missing from the timer0 numbers.
+
+ucsim models a classic 12T 8051, 12 clocks per machine cycle. The STC15 is a
+1T core and runs about one machine cycle per clock, so the ISR clocks measured
+are divided by 12 and reported as machine cycles, and the CPU shares are these
+cycles against the period of the interrupt in real (1T) oscillator clocks.
+Some STC15 instructions take more than one clock, so the real shares are
+somewhat higher.
+"""
+
+import argparse
+import os
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import ucsim
+
+VECTORS = {'timer0_isr': 0x000B, 'timer1_isr': 0x001B, 'int3_isr': 0x005B}
+RETI_CLKS = 24          # reti is 2 machine cycles
+SIM_CLKS = 12           # clocks per machine cycle of the simulated core
+P3_7 = 0xB7             # bit address of RXB
+
+
+def rx_waveform(text):
+    """Line level per timer0 tick for 8N1 at 3 ticks per bit, with idle between bytes."""
+    levels = []
+    for c in bytearray(text):
+        bits = [0] + [(c >> i) & 1 for i in range(8)] + [1, 1]
+        for b in bits:
+            levels += [b] * 3
+    return levels
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument('--s51', default='s51')
+    ap.add_argument('--samples', type=int, default=2000, help='timer0 runs to measure')
+    ap.add_argument('--fosc', type=int, default=11059200)
+    ap.add_argument('--baud', type=int, default=9600)
+    ap.add_argument('ihx', nargs='?', default='build/main.ihx')
+    ap.add_argument('rst', nargs='?', default='build/main.rst')
+    args = ap.parse_args()
+
+    funcs = ucsim.rst_functions(args.rst)
+    exits = {}
+    for isr in VECTORS:
+        if isr not in funcs or not funcs[isr]['ret']:
+            sys.exit('%s not found in %s' % (isr, args.rst))
+        for a in funcs[isr]['ret']:
+            exits[a] = isr
+
+    # oscillator clocks between runs, same reloads as Timer0Init() (1T mode) and Timer1Init() (12T mode)
+    period = {
+        'timer0_isr': (args.fosc + args.baud * 3 // 2) // (args.baud * 3),
+        'timer1_isr': args.fosc // 12 // 100 * 12,
+        'int3_isr': args.fosc * 10 // args.baud,   # once per byte at most
+    }
+
+    sim = ucsim.Sim(args.s51, args.ihx, args.fosc)
+    for a in [VECTORS['timer0_isr'], VECTORS['timer1_isr']] + list(exits):
+        sim.cmd('break 0x%x' % a)
+
+    wave = rx_waveform(b'$GPRMC,182600.00,A,,,,,,,210916,,,A*65\r\n')
+    stats = dict((isr, []) for isr in VECTORS)
+    entry = {}
+    ticks = 0
+    level = 1
+    try:
+        while len(stats['timer0_isr']) < args.samples:
+            pc, clks = sim.run_to_break()
+            if pc == VECTORS['timer0_isr']:
+                new = wave[ticks % len(wave)]
+                sim.cmd('set bit 0x%x %d' % (P3_7, new))
+                ticks += 1
+                if level and not new:
+                    sim.cmd('pc 0x%x' % VECTORS['int3_isr'])
+                    pc = VECTORS['int3_isr']
+                level = new
+            for isr, vec in VECTORS.items():
+                if pc == vec:
+                    entry[isr] = clks
+            if pc in exits and exits[pc] in entry:
+                isr = exits[pc]
+                stats[isr].append(clks - entry.pop(isr) + RETI_CLKS)
+    finally:
+        sim.close()
+
+    print('%-12s %6s %8s %8s %10s %10s' % ('isr', 'runs', 'avg', 'max', 'period', 'cpu avg/max'))
+    for isr in sorted(VECTORS):
+        s = stats[isr]
+        if not s:
+            print('%-12s %6d %8s %8s' % (isr, 0, '-', '-'))
+            continue
+        avg = float(sum(s)) / len(s) / SIM_CLKS
+        mx = float(max(s)) / SIM_CLKS
+        print('%-12s %6d %8.1f %8.0f %10d %5.1f%%/%.1f%%' % (isr, len(s), avg, mx, period[isr],
+              100.0 * avg / period[isr], 100.0 * mx / period[isr]))
+    print('(avg/max in machine cycles, period in 1T clocks at %.4f MHz)' % (args.fosc / 1e6))
+
+
+if __name__ == '__main__':
+    main()
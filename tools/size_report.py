@@ -0,0 +1,153 @@
+#!/usr/bin/env python3
+"""Code and RAM use of the firmware for every combination of the CFG_* options.
+
+Each combination is built into build/size/<tag>/ through the Makefile's ihx
+target. The sdcc .map file gives the bytes per global symbol (the distance to
+the next symbol of the same area, so static functions are counted with the
+global one in front of them), the .mem file the totals against --code-size
+and --iram-size.
+
+tag letters: A alarm, C chime, S set date/time, H hour mode, T temperature unit;
+before them the build of a plain `make` (default) and the largest GPS option
+sets (gps-pps, gps-auto, gps-ubx), the ones to check before adding to a
+default-on feature
+"""
+
+import argparse
+import itertools
+import os
+import re
+import shutil
+import subprocess
+import sys
+
+OPTIONS = [
+    ('CFG_ALARM', 'A', ['0', '1']),
+    ('CFG_CHIME', 'C', ['0', '1']),
+    ('CFG_SET_DATE_TIME', 'S', ['0', '1']),
+    ('CFG_HOUR_MODE', 'H', ['24', '12']),
+    ('CFG_TEMP_UNIT', 'T', ["'C'", "'F'"]),
+]
+
+# everything of the GPS code that builds together, with the default display options
+_GPS = [('CFG_GPS_SYNC_INTERVAL', '240'), ('CFG_GPS_HOLDOVER', '1'), ('CFG_GPS_CONSENSUS', '1'),
+        ('CFG_SOFT_CLOCK', '1')]
+NAMED = [
+    ('default', []),
+    ('gps-pps', _GPS + [('CFG_GPS_PPS', '1'), ('CFG_GPS_STATUS', '1'), ('CFG_GPS_INIT', "'M'")]),
+    ('gps-auto', _GPS + [('CFG_GPS_AUTO_CORRECTION', '1'), ('CFG_GPS_STATUS', '1'), ('CFG_GPS_INIT', "'M'")]),
+    ('gps-ubx', _GPS + [('CFG_GPS_UBX', '1'), ('CFG_GPS_PPS', '1'), ('CFG_GPS_INIT', "'U'")]),
+]
+
+CODE_AREAS = ('HOME', 'GSINIT', 'GSFINAL', 'CSEG', 'CONST', 'XINIT', 'CABS', 'RSEG')
+RAM_AREAS = ('DSEG', 'OSEG', 'ISEG', 'IABS', 'BSEG', 'BIT_BANK', 'REG_BANK_0', 'REG_BANK_1')
+
+_AREA = re.compile(r'^(\w+)\s+([0-9A-Fa-f]{8})\s+([0-9A-Fa-f]{8})\s+=\s+(\d+)\.\s+bytes\s+\(([^)]*)\)')
+_SYMBOL = re.compile(r'^\s+(?:[A-Z]:\s+)?([0-9A-Fa-f]{8})\s+(_\w+)\s*(\S*)')
+_ROM = re.compile(r'ROM/EPROM/FLASH\s+0x[0-9A-Fa-f]+\s+0x[0-9A-Fa-f]+\s+(\d+)\s+(\d+)')
+_STACK = re.compile(r'Stack starts at: 0x([0-9A-Fa-f]+).*with (\d+) bytes available')
+
+
+def parse_map(path):
+    """{area: (start, size, [(addr, symbol, module)])} from an sdld .map file."""
+    areas = {}
+    cur = None
+    with open(path) as f:
+        for line in f:
+            m = _AREA.match(line)
+            if m:
+                cur = m.group(1)
+                areas[cur] = (int(m.group(2), 16), int(m.group(4)), [])
+                continue
+            m = _SYMBOL.match(line)
+            if m and cur:
+                areas[cur][2].append((int(m.group(1), 16), m.group(2), m.group(3)))
+    return areas
+
+
+def symbol_sizes(areas, names):
+    """symbol -> bytes, summed over the areas in names."""
+    sizes = {}
+    for name in names:
+        if name not in areas:
+            continue
+        start, size, syms = areas[name]
+        syms = sorted(syms)
+        end = start + size
+        for i, (addr, sym, _) in enumerate(syms):
+            nxt = syms[i + 1][0] if i + 1 < len(syms) else end
+            sizes[sym] = sizes.get(sym, 0) + max(0, nxt - addr)
+    return sizes
+
+
+def parse_mem(path):
+    rom_used = rom_max = stack = None
+    with open(path) as f:
+        text = f.read()
+    m = _ROM.search(text)
+    if m:
+        rom_used, rom_max = int(m.group(1)), int(m.group(2))
+    m = _STACK.search(text)
+    if m:
+        stack = int(m.group(2))
+    return rom_used, rom_max, stack
+
+
+def build(make, tag, defines):
+    out = os.path.join('build', 'size', tag)
+    shutil.rmtree(out, ignore_errors=True)
+    # the recipe goes through the shell, which would take the quotes off 'C'
+    opts = ' '.join('-D%s="%s"' % d for d in defines)
+    r = subprocess.run([make, '-s', 'BUILD=' + out, 'COMPILEOPT=' + opts, 'ihx'],
+                       stdout=subprocess.PIPE, stderr=subprocess.STDOUT, universal_newlines=True)
+    return out, r.returncode == 0, r.stdout
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument('--make', default='make')
+    ap.add_argument('--summary', action='store_true', help='only the table of totals')
+    ap.add_argument('--only', help='build just this tag, e.g. default or A0C0S0H24TC')
+    args = ap.parse_args()
+
+    configs = list(NAMED)
+    for values in itertools.product(*[o[2] for o in OPTIONS]):
+        tag = ''.join(o[1] + v.strip("'") for o, v in zip(OPTIONS, values))
+        configs.append((tag, [(o[0], v) for o, v in zip(OPTIONS, values)]))
+
+    results = []
+    for tag, defines in configs:
+        if args.only and tag != args.only:
+            continue
+        out, ok, log = build(args.make, tag, defines)
+        mem, mapf = os.path.join(out, 'main.mem'), os.path.join(out, 'main.map')
+        if not os.path.exists(mem) or not os.path.exists(mapf):
+            results.append((tag, ok, None, None, None))
+            print('%s: build failed\n%s' % (tag, log.strip()), file=sys.stderr)
+            continue
+
+        rom_used, rom_max, stack = parse_mem(mem)
+        results.append((tag, ok, rom_used, rom_max, stack))
+        if args.summary:
+            continue
+
+        areas = parse_map(mapf)
+        code = symbol_sizes(areas, CODE_AREAS)
+        ram = symbol_sizes(areas, RAM_AREAS)
+        print('== %s  %s' % (tag, ' '.join('%s=%s' % d for d in defines)))
+        print('   %-32s %6s %5s' % ('symbol', 'code', 'ram'))
+        for sym in sorted(set(code) | set(ram), key=lambda s: (-code.get(s, 0), -ram.get(s, 0), s)):
+            print('   %-32s %6s %5s' % (sym, code.get(sym, '') or '', ram.get(sym, '') or ''))
+        print()
+
+    print('%-14s %-6s %6s %6s %6s %11s' % ('config', 'result', 'code', 'max', 'free', 'stack bytes'))
+    for tag, ok, rom_used, rom_max, stack in results:
+        if rom_used is None:
+            print('%-14s %-6s' % (tag, 'failed'))
+            continue
+        print('%-14s %-6s %6d %6d %6d %11s' % (tag, 'fits' if ok else 'FULL', rom_used, rom_max,
+              rom_max - rom_used, stack if stack is not None else '-'))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,107 @@
+"""Helpers to drive sdcc's ucsim (s51) and read sdcc listings.
+
+Cycle counts are taken from ucsim's "state" command ("... (N clks)"), i.e.
+oscillator clocks of the simulated classic 12T 8051 core.
+"""
+
+import os
+import re
+import select
+import subprocess
+import time
+
+# sdcc relocated listing line: address, code bytes, optional [cycles], line number, source
+_RST_LINE = re.compile(r'^\s*([0-9A-Fa-f]{4,8})\s+((?:[0-9A-Fa-f]{2}\s)*)\s*(?:\[\s*\d+\])?\s*\d+\s+(.*)$')
+_RST_FUNC = re.compile(r';\s+function\s+(\w+)')
+# aslink map symbol line: [area letter:] address, global symbol, module it is defined in
+_MAP_SYM = re.compile(r'^\s*(?:[A-Z]:\s+)?([0-9A-Fa-f]{4,8})\s+_(\w+)\s+(\w+)\s*$')
+_STOP = re.compile(r'Stop at (0x[0-9A-Fa-f]+)')
+_CLKS = re.compile(r'\((\d+) clks\)')
+
+
+def rst_functions(path):
+    """Map function name -> {'entry': addr, 'ret': [addrs of ret/reti]} from an sdcc .rst file."""
+    funcs = {}
+    cur = None
+    with open(path) as f:
+        for line in f:
+            m = _RST_FUNC.search(line)
+            if m:
+                cur = {'entry': None, 'ret': []}
+                funcs[m.group(1)] = cur
+                continue
+            if cur is None:
+                continue
+            m = _RST_LINE.match(line)
+            if not m:
+                continue
+            addr = int(m.group(1), 16)
+            src = m.group(3).split(';')[0].strip()
+            if src.startswith('.area'):
+                cur = None
+            elif cur['entry'] is None and src.endswith(':') and src.startswith('_'):
+                cur['entry'] = addr
+            elif src in ('ret', 'reti'):
+                cur['ret'].append(addr)
+    return dict((k, v) for k, v in funcs.items() if v['entry'] is not None)
+
+
+def map_symbols(path):
+    """Map C name -> (addr, module) of the global symbols in an sdcc/aslink .map file."""
+    syms = {}
+    with open(path) as f:
+        for line in f:
+            m = _MAP_SYM.match(line)
+            if m:
+                syms[m.group(2)] = (int(m.group(1), 16), m.group(3))
+    return syms
+
+
+class Sim(object):
+    """A running s51 instance talked to over its console."""
+
+    def __init__(self, s51, ihx, xtal=11059200, timeout=60):
+        if not os.path.exists(ihx):
+            raise SystemExit('%s not found, build the firmware first' % ihx)
+        self.timeout = timeout
+        self.proc = subprocess.Popen([s51, '-X', str(xtal), ihx],
+                                     stdin=subprocess.PIPE, stdout=subprocess.PIPE,
+                                     stderr=subprocess.STDOUT, bufsize=0)
+        self.buf = b''
+        self.read_until(re.compile(r'\d+> $'))
+
+    def read_until(self, pattern):
+        deadline = time.time() + self.timeout
+        while True:
+            m = pattern.search(self.buf.decode('latin-1'))
+            if m:
+                out = self.buf.decode('latin-1')
+                self.buf = b''
+                return out
+            left = deadline - time.time()
+            if left <= 0 or self.proc.poll() is not None:
+                raise SystemExit('ucsim did not answer, last output:\n' + self.buf.decode('latin-1'))
+            r, _, _ = select.select([self.proc.stdout], [], [], left)
+            if r:
+                self.buf += os.read(self.proc.stdout.fileno(), 4096)
+
+    def cmd(self, line):
+        self.proc.stdin.write((line + '\n').encode())
+        return self.read_until(re.compile(r'\d+> $'))
+
+    def run_to_break(self):
+        """Continue until a breakpoint, return (pc, clks)."""
+        self.proc.stdin.write(b'run\n')
+        out = self.read_until(re.compile(r'Stop at 0x[0-9A-Fa-f]+.*\n(?:.*\n)*?.*\d+> $'))
+        pc = int(_STOP.search(out).group(1), 16)
+        return pc, self.clks()
+
+    def clks(self):
+        return int(_CLKS.search(self.cmd('state')).group(1))
+
+    def close(self):
+        try:
+            self.proc.stdin.write(b'quit\n')
+            self.proc.wait(5)
+        except Exception:
+            self.proc.kill()